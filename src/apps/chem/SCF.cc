@@ -41,6 +41,7 @@
 #include <chem/nemo.h>
 #include <chem/projector.h>
 #include <madness/mra/qmprop.h>
+#include <madness/tensor/vmath.h>
 #include <madness/world/worldmem.h>
 
 #include <cmath>
@@ -66,8 +67,10 @@ static void verify_tree(World& world, const std::vector<Function<T, NDIM>>& v) {
 template <int NDIM>
 struct unaryexp {
   void operator()(const Key<NDIM>& key, Tensor<double_complex>& t) const {
-    // vzExp(t.size, t.ptr(), t.ptr());
-    UNARY_OPTIMIZED_ITERATOR(double_complex, t, *_p0 = exp(*_p0););
+    if (t.iscontiguous())
+      vexp(t.size(), t.ptr(), t.ptr());
+    else
+      UNARY_OPTIMIZED_ITERATOR(double_complex, t, *_p0 = exp(*_p0););
   }
   template <typename Archive>
   void serialize(Archive& ar) {}
@@ -429,12 +432,11 @@ vecfuncT SCF::project_ao_basis(World& world, const AtomicBasisSet& aobasis) {
 }
 
 vecfuncT SCF::project_ao_basis_only(World& world, const AtomicBasisSet& aobasis, const Molecule& molecule) {
-  vecfuncT ao = vecfuncT(aobasis.nbf(molecule));
+  std::vector<functorT> aofuncs(aobasis.nbf(molecule));
   for (int i = 0; i < aobasis.nbf(molecule); ++i) {
-    functorT aofunc(new AtomicBasisFunctor(aobasis.get_atomic_basis_function(molecule, i)));
-    ao[i] = factoryT(world).functor(aofunc).truncate_on_project().nofence().truncate_mode(1);
+    aofuncs[i] = functorT(new AtomicBasisFunctor(aobasis.get_atomic_basis_function(molecule, i)));
   }
-  world.gop.fence();
+  vecfuncT ao = project_functors(world, aofuncs, factoryT(world).truncate_on_project().truncate_mode(1));
   truncate(world, ao);
   normalize(world, ao);
   return ao;
@@ -3511,7 +3513,7 @@ functionT SCF::make_derivative_density(World& world,
   functionT drho = factoryT(world);
   drho.compress();
   for (size_t i = 0; i < mo.size(); ++i) {
-    functionT rhoi = mo[i] * x[i] + mo[i] * y[i];
+    functionT rhoi = lazy(mo[i]) * x[i] + lazy(mo[i]) * y[i];
     rhoi.compress();
     if (occ[i]) drho.gaxpy(1.0, rhoi, occ[i], false);
     // drho += (mo[i] * x[i]) + (mo[i] * y[i]);
@@ -145,6 +145,24 @@ class AtomicBasisFunctor : public FunctionFunctorInterface<double, 3> {
 
   double operator()(const coordT& x) const { return aofunc(x[0], x[1], x[2]); }
 
+  bool supports_vectorized() const { return true; }
+
+  void operator()(const Vector<double*, 3>& xvals, double* fvals, int npts) const {
+    aofunc(xvals[0], xvals[1], xvals[2], fvals, npts);
+  }
+
+  /// The function vanishes identically in boxes beyond the range of the shell
+  bool screened(const coordT& c1, const coordT& c2) const {
+    const coordT center = aofunc.get_coords_vec();
+    double rsq = 0.0;
+    for (std::size_t d = 0; d < 3; ++d) {
+      const double lo = std::min(c1[d], c2[d]), hi = std::max(c1[d], c2[d]);
+      const double dx = center[d] - std::max(lo, std::min(hi, center[d]));
+      rsq += dx * dx;
+    }
+    return rsq > aofunc.rangesq();
+  }
+
   std::vector<coordT> special_points() const { return std::vector<coordT>(1, aofunc.get_coords_vec()); }
 };
 
@@ -50,12 +50,8 @@ DistributedMatrix<T> Kinetic<T, NDIM>::kinetic_energy_matrix(World& world, const
   DistributedMatrix<T> r = column_distributed_matrix<T>(world, n, n);
   reconstruct(world, v);
 
-  // apply the derivative operator on each function for each dimension
-  std::vector<vecfuncT> dv(NDIM);
-  for (std::size_t i = 0; i < NDIM; ++i) {
-    dv[i] = apply(world, *(gradop[i]), v, false);
-  }
-  world.gop.fence();
+  // apply all derivative operators on each function in a single traversal
+  std::vector<vecfuncT> dv = apply_derivatives(world, gradop, v);
   for (std::size_t i = 0; i < NDIM; ++i) {
     compress(world, dv[i], false);
   }
@@ -78,13 +74,16 @@ DistributedMatrix<T> Kinetic<T, NDIM>::kinetic_energy_matrix(World& world,
   reconstruct(world, vket);
   const auto bra_equiv_ket = &vbra == &vket;
 
-  // apply the derivative operator on each function for each dimension
+  // apply all derivative operators on each function in a single traversal,
+  // bra and ket in one batch
+  vecfuncT braket(vbra);
+  braket.insert(braket.end(), vket.begin(), vket.end());
+  std::vector<vecfuncT> dv = apply_derivatives(world, gradop, braket);
   std::vector<vecfuncT> dvbra(NDIM), dvket(NDIM);
   for (std::size_t i = 0; i < NDIM; ++i) {
-    dvbra[i] = apply(world, *(gradop[i]), vbra, false);
-    dvket[i] = apply(world, *(gradop[i]), vket, false);
+    dvbra[i].assign(dv[i].begin(), dv[i].begin() + n);
+    dvket[i].assign(dv[i].begin() + n, dv[i].end());
   }
-  world.gop.fence();
   for (std::size_t i = 0; i < NDIM; ++i) {
     compress(world, dvbra[i], false);
     compress(world, dvket[i], false);
@@ -128,8 +127,12 @@ std::vector<Function<T, NDIM>> Laplacian<T, NDIM>::operator()(const std::vector<
   vecfuncT result = zero_functions_compressed<T, NDIM>(world, vket.size());
   SeparatedConvolution<T, NDIM> smooth = SmoothingOperator<NDIM>(world, eps);
 
+  // first derivatives in all directions in a single traversal of each function
+  std::vector<vecfuncT> dv = apply_derivatives(world, gradop, vket);
+
   for (size_t idim = 0; idim < NDIM; ++idim) {
-    vecfuncT dvket = apply(world, *gradop[idim].get(), vket);
+    vecfuncT dvket = dv[idim];
+    dv[idim].clear();
     refine(world, dvket);
     if (eps > 0.0) dvket = apply(world, smooth, dvket);
     vecfuncT ddvket = apply(world, *gradop[idim].get(), dvket);
@@ -352,14 +355,62 @@ std::vector<Function<T, NDIM>> Exchange<T, NDIM>::operator()(const std::vector<F
     reconstruct(world, vket);
     norm_tree(world, vket);
   }
+  // pre-screen the pairs by the spatial extent of the orbitals: bounds(i,j)
+  // is an upper bound for the 1-norm of the pair density <i|phi_j>
+  const double ptol = (pair_tol_ < 0.0) ? 0.01 * tol : pair_tol_;
+  const Tensor<double> bounds = overlap_bounds(world, mo_bra, vket);
+  npairs_computed_ = npairs_screened_ = 0;
+
   // sum_i |i><i|J|p> for each p
   // for each occ orbital
-  if (small_memory_) {  // Smaller memory algorithm ... possible 2x saving using
-                        // i-j sym
+  if (fused_) {  // Fused algorithm ... O(nocc) intermediates, no i-j sym
+    for (int j = 0; j < nf; ++j) {
+      std::vector<int> ilist;
+      for (int i = 0; i < nocc; ++i) {
+        if (occ[i] == 0.0) continue;
+        if (bounds(i, j) < ptol)
+          ++npairs_screened_;
+        else
+          ilist.push_back(i);
+      }
+      if (ilist.size() == 0) continue;
+      npairs_computed_ += ilist.size();
+
+      vecfuncT bra(ilist.size()), ket(ilist.size());
+      Tensor<double> occ_j(ilist.size());
+      for (std::size_t k = 0; k < ilist.size(); ++k) {
+        bra[k] = mo_bra[ilist[k]];
+        ket[k] = mo_ket[ilist[k]];
+        occ_j(k) = occ[ilist[k]];
+      }
+
+      // all products <i|phi_j> in one traversal of phi_j
+      vecfuncT psif = mul_sparse(world, vket[j], bra, mul_tol);
+      truncate(world, psif);
+      psif = apply(world, *poisson.get(), psif);
+      truncate(world, psif);
+      // sum_i occ_i |i> <i|J|phi_j> without forming the products
+      Kf[j] = fused_dot(world, ket, psif, occ_j);
+      Kf[j].compress();
+      // the products and potentials of ket j go out of scope here
+    }
+  } else if (small_memory_) {  // Smaller memory algorithm ... possible 2x saving using
+                               // i-j sym
     for (int i = 0; i < nocc; ++i) {
       if (occ[i] > 0.0) {
+        std::vector<int> jlist;
+        vecfuncT vketi;
+        for (int j = 0; j < nf; ++j) {
+          if (bounds(i, j) < ptol) continue;
+          jlist.push_back(j);
+          vketi.push_back(vket[j]);
+        }
+        npairs_screened_ += nf - jlist.size();
+        npairs_computed_ += jlist.size();
+        if (jlist.size() == 0) continue;
+
         // for each |i> <i|phi>
-        vecfuncT psif = mul_sparse(world, mo_bra[i], vket, mul_tol);  /// was vtol
+        vecfuncT psif = mul_sparse(world, mo_bra[i], vketi, mul_tol);  /// was vtol
         truncate(world, psif);
         // apply to vector of products <i|phi>..<i|1> <i|2>...<i|N>
         psif = apply(world, *poisson.get(), psif);
@@ -368,18 +419,27 @@ std::vector<Function<T, NDIM>> Exchange<T, NDIM>::operator()(const std::vector<F
         psif = mul_sparse(world, mo_ket[i], psif, mul_tol);  /// was vtol
         /// Generalized A*X+Y for vectors of functions ---- a[i] = alpha*a[i] +
         // 1*Kf+occ[i]*psif
-        gaxpy(world, 1.0, Kf, occ[i], psif);
+        compress(world, psif);
+        for (std::size_t k = 0; k < jlist.size(); ++k) Kf[jlist[k]].gaxpy(1.0, psif[k], occ[i], false);
+        world.gop.fence();
       }
     }
   } else {  // Larger memory algorithm ... use i-j sym if psi==f
     vecfuncT psif;
+    std::vector<std::pair<int, int>> pairs;
     for (int i = 0; i < nocc; ++i) {
       int jtop = nf;
       if (same) jtop = i + 1;
       for (int j = 0; j < jtop; ++j) {
+        if (bounds(i, j) < ptol) {
+          ++npairs_screened_;
+          continue;
+        }
+        pairs.push_back(std::make_pair(i, j));
         psif.push_back(mul_sparse(mo_bra[i], vket[j], mul_tol, false));
       }
     }
+    npairs_computed_ = pairs.size();
 
     world.gop.fence();
     truncate(world, psif, tol);
@@ -387,26 +447,25 @@ std::vector<Function<T, NDIM>> Exchange<T, NDIM>::operator()(const std::vector<F
     truncate(world, psif, tol);
     reconstruct(world, psif);
     norm_tree(world, psif);
-    vecfuncT psipsif = zero_functions<T, NDIM>(world, nf * nocc);
-    int ij = 0;
-    for (int i = 0; i < nocc; ++i) {
-      int jtop = nf;
-      if (same) jtop = i + 1;
-      for (int j = 0; j < jtop; ++j, ++ij) {
-        psipsif[i * nf + j] = mul_sparse(psif[ij], mo_ket[i], mul_tol, false);
-        if (same && i != j) {
-          psipsif[j * nf + i] = mul_sparse(psif[ij], mo_ket[j], mul_tol, false);
-        }
+    // psipsif[k] contributes to Kf[j] with weight occ[i], where (i,j)=targets[k]
+    vecfuncT psipsif;
+    std::vector<std::pair<int, int>> targets;
+    for (std::size_t ij = 0; ij < pairs.size(); ++ij) {
+      const int i = pairs[ij].first;
+      const int j = pairs[ij].second;
+      psipsif.push_back(mul_sparse(psif[ij], mo_ket[i], mul_tol, false));
+      targets.push_back(std::make_pair(i, j));
+      if (same && i != j) {
+        psipsif.push_back(mul_sparse(psif[ij], mo_ket[j], mul_tol, false));
+        targets.push_back(std::make_pair(j, i));
       }
     }
     world.gop.fence();
     psif.clear();
     world.gop.fence();
     compress(world, psipsif);
-    for (int i = 0; i < nocc; ++i) {
-      for (int j = 0; j < nf; ++j) {
-        Kf[j].gaxpy(1.0, psipsif[i * nf + j], occ[i], false);
-      }
+    for (std::size_t k = 0; k < psipsif.size(); ++k) {
+      Kf[targets[k].second].gaxpy(1.0, psipsif[k], occ[targets[k].first], false);
     }
     world.gop.fence();
     psipsif.clear();
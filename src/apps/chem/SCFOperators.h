@@ -496,10 +496,40 @@ class Exchange : public SCFOperatorBase<T, NDIM> {
     return *this;
   }
 
+  /// use the fused algorithm: the orbital products of one ket function are
+  /// formed in a single traversal and the potentials are multiplied with the
+  /// kets and summed box by box, so only O(nocc) intermediates are alive at
+  /// any time; takes precedence over small_memory
+  bool& fused() { return fused_; }
+  bool fused() const { return fused_; }
+  Exchange& fused(const bool flag) {
+    fused_ = flag;
+    return *this;
+  }
+
+  /// pairs (i,j) with an upper bound of the 1-norm of <i|j> below this
+  /// threshold are skipped; a negative value means 0.01*thresh
+
+  /// This is a heuristic: the 1-norm of the pair density does not bound
+  /// the error of the skipped term |i> J(<i|j>) in K, which also depends on
+  /// the Coulomb operator and on |i>. Set 0 to disable the screening.
+  double& pair_tol() { return pair_tol_; }
+  double pair_tol() const { return pair_tol_; }
+  Exchange& pair_tol(const double tol) {
+    pair_tol_ = tol;
+    return *this;
+  }
+
+  /// number of pairs (computed, screened) in the last application
+  std::pair<long, long> pair_statistics() const { return std::make_pair(npairs_computed_, npairs_screened_); }
+
  private:
   World& world;
   bool small_memory_ = true;
   bool same_ = false;
+  bool fused_ = false;
+  double pair_tol_ = -1.0;
+  mutable long npairs_computed_ = 0, npairs_screened_ = 0;
   vecfuncT mo_bra, mo_ket;  ///< MOs for bra and ket
   Tensor<double> occ;
   std::shared_ptr<real_convolution_3d> poisson;
@@ -117,6 +117,32 @@ public:
     }
 
 
+    /// Evaluates the radial part of the contracted function at npt points
+    void eval_radial(const double* MADNESS_RESTRICT rsq, double* MADNESS_RESTRICT R, int npt) const {
+        for (int i=0; i<npt; ++i) R[i] = 0.0;
+        for (unsigned int j=0; j<coeff.size(); ++j) {
+            const double c = coeff[j], e = expnt[j];
+            for (int i=0; i<npt; ++i) {
+                double ersq = e*rsq[i];
+                R[i] += (ersq < 27.6) ? c*exp(-ersq) : 0.0; // 27.6 = log(1e12)
+            }
+        }
+        for (int i=0; i<npt; ++i) if (rsq[i] > rsqmax) R[i] = 0.0;
+    }
+
+
+    /// Returns the powers of x, y and z of basis function ibf of the shell (see eval())
+    void angular_powers(int ibf, int& lx, int& ly, int& lz) const {
+        for (lx=type; lx>=0; --lx) {
+            for (ly=type-lx; ly>=0; --ly, --ibf) {
+                lz = type-lx-ly;
+                if (ibf == 0) return;
+            }
+        }
+        throw "UNKNOWN BASIS FUNCTION INDEX";
+    }
+
+
     /// Evaluates the entire shell returning the incremented result pointer
     double* eval(double rsq, double x, double y, double z, double* bf) const {
         double R = eval_radial(rsq);
@@ -433,6 +459,30 @@ public:
         return bf[ibf];
     }
 
+    /// Evaluates the function at npt points given by the arrays x, y and z
+    void operator()(const double* MADNESS_RESTRICT x, const double* MADNESS_RESTRICT y,
+                    const double* MADNESS_RESTRICT z, double* MADNESS_RESTRICT f, int npt) const {
+        std::vector<double> dx(npt), dy(npt), dz(npt), rsq(npt);
+        for (int i=0; i<npt; ++i) {
+            dx[i] = x[i]-xx;
+            dy[i] = y[i]-yy;
+            dz[i] = z[i]-zz;
+            rsq[i] = dx[i]*dx[i] + dy[i]*dy[i] + dz[i]*dz[i];
+        }
+        shell.eval_radial(&rsq[0], f, npt);
+
+        int lx, ly, lz;
+        shell.angular_powers(ibf, lx, ly, lz);
+        for (int i=0; i<npt; ++i) {
+            double R = f[i];
+            if (fabs(R) < 1e-12) R = 0.0;
+            for (int p=0; p<lx; ++p) R *= dx[i];
+            for (int p=0; p<ly; ++p) R *= dy[i];
+            for (int p=0; p<lz; ++p) R *= dz[i];
+            f[i] = R;
+        }
+    }
+
     void print_me(std::ostream& s) const;
 
     const ContractedGaussianShell& get_shell() const {
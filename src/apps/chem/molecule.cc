@@ -43,6 +43,7 @@
 #include <madness/misc/misc.h>
 #include <iomanip>
 #include <set>
+#include <map>
 
 namespace madness
 {
@@ -958,6 +959,151 @@ double Molecule::nuclear_attraction_potential(double x, double y, double z) cons
     return sum;
 }
 
+void Molecule::nuclear_attraction_potential(const double* MADNESS_RESTRICT x, const double* MADNESS_RESTRICT y,
+                                            const double* MADNESS_RESTRICT z, double* MADNESS_RESTRICT v, int npt) const
+{
+    // atoms in the outer loop so that the distances vectorize
+    std::vector<double> r(npt);
+    for (int i = 0; i < npt; ++i) v[i] = field[0] * x[i] + field[1] * y[i] + field[2] * z[i];
+    for (unsigned int j = 0; j < atoms.size(); ++j)
+    {
+        if (atoms[j].pseudo_atom)
+            continue;
+
+        const double xj = atoms[j].x, yj = atoms[j].y, zj = atoms[j].z;
+        const double rc = rcut[j], qrc = atoms[j].q * rcut[j];
+        for (int i = 0; i < npt; ++i)
+        {
+            const double dx = x[i] - xj, dy = y[i] - yj, dz = z[i] - zj;
+            r[i] = sqrt(dx * dx + dy * dy + dz * dz) * rc;
+        }
+        for (int i = 0; i < npt; ++i) v[i] -= qrc * smoothed_potential(r[i]);
+    }
+}
+
+AtomCellList::AtomCellList(const Molecule& molecule, double tol, double width) : tol(tol)
+{
+    MADNESS_ASSERT(width > 0.0);
+    for (int d = 0; d < 3; ++d) field[d] = molecule.get_field()[d];
+    const std::vector<double> rc = molecule.get_rcut();
+    for (unsigned int i = 0; i < molecule.natom(); ++i)
+    {
+        if (molecule.get_atom(i).pseudo_atom) continue;
+        atoms.push_back(molecule.get_atom(i));
+        rcut.push_back(rc[i]);
+    }
+
+    std::map< std::vector<long>, int > index;
+    for (unsigned int j = 0; j < atoms.size(); ++j)
+    {
+        const double r[3] = {atoms[j].x, atoms[j].y, atoms[j].z};
+        std::vector<long> l(3);
+        for (int d = 0; d < 3; ++d) l[d] = long(std::floor(r[d] / width));
+        std::map< std::vector<long>, int >::iterator it = index.find(l);
+        if (it == index.end())
+        {
+            it = index.insert(std::make_pair(l, int(cells.size()))).first;
+            Cell cell;
+            for (int d = 0; d < 3; ++d) cell.center[d] = (l[d] + 0.5) * width;
+            cell.radius = cell.rsmooth = cell.charge = cell.abscharge = 0.0;
+            for (int d = 0; d < 3; ++d) cell.dipole[d] = 0.0;
+            for (int d = 0; d < 6; ++d) cell.quadrupole[d] = 0.0;
+            cells.push_back(cell);
+        }
+
+        Cell& cell = cells[it->second];
+        const double q = atoms[j].q;
+        const double s[3] = {r[0] - cell.center[0], r[1] - cell.center[1], r[2] - cell.center[2]};
+        cell.atoms.push_back(j);
+        cell.radius = std::max(cell.radius, sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]));
+        cell.rsmooth = std::max(cell.rsmooth, 7.0 / rcut[j]); // smoothed_potential(r) = 1/r for r > 7
+        cell.charge += q;
+        cell.abscharge += std::abs(q);
+        for (int d = 0; d < 3; ++d) cell.dipole[d] += q * s[d];
+        cell.quadrupole[0] += q * s[0] * s[0];
+        cell.quadrupole[1] += q * s[0] * s[1];
+        cell.quadrupole[2] += q * s[0] * s[2];
+        cell.quadrupole[3] += q * s[1] * s[1];
+        cell.quadrupole[4] += q * s[1] * s[2];
+        cell.quadrupole[5] += q * s[2] * s[2];
+    }
+    celltol = cells.empty() ? tol : tol / cells.size();
+}
+
+void AtomCellList::nuclear_attraction_potential(const double* MADNESS_RESTRICT x, const double* MADNESS_RESTRICT y,
+                                                const double* MADNESS_RESTRICT z, double* MADNESS_RESTRICT v, int npt) const
+{
+    if (npt <= 0) return;
+
+    // bounding box of the points
+    double lo[3] = {x[0], y[0], z[0]}, hi[3] = {x[0], y[0], z[0]};
+    for (int i = 0; i < npt; ++i)
+    {
+        v[i] = field[0] * x[i] + field[1] * y[i] + field[2] * z[i];
+        lo[0] = std::min(lo[0], x[i]); hi[0] = std::max(hi[0], x[i]);
+        lo[1] = std::min(lo[1], y[i]); hi[1] = std::max(hi[1], y[i]);
+        lo[2] = std::min(lo[2], z[i]); hi[2] = std::max(hi[2], z[i]);
+    }
+
+    std::vector<double> r(npt);
+    for (const Cell& cell : cells)
+    {
+        // distance between the cell center and the closest point
+        double dsq = 0.0;
+        for (int d = 0; d < 3; ++d)
+        {
+            const double dd = cell.center[d] - std::max(lo[d], std::min(hi[d], cell.center[d]));
+            dsq += dd * dd;
+        }
+        const double dist = sqrt(dsq);
+        const double a = cell.radius;
+
+        // the expansion is of the bare charges, so no point may be inside a smoothed region
+        if (dist - a > cell.rsmooth && cell.abscharge * a * a * a < celltol * dist * dist * dist * (dist - a))
+        {
+            // far field: \sum_j q_j/|d-s_j| truncated after the quadrupole term,
+            // the remainder is bounded by \sum_j |q_j| a^3/(D^3 (D-a))
+            const double* P = cell.dipole;
+            const double* M = cell.quadrupole;
+            const double trM = M[0] + M[3] + M[5];
+            for (int i = 0; i < npt; ++i)
+            {
+                const double dx = x[i] - cell.center[0], dy = y[i] - cell.center[1], dz = z[i] - cell.center[2];
+                const double d2 = dx * dx + dy * dy + dz * dz;
+                const double rinv = 1.0 / sqrt(d2);
+                const double rinv3 = rinv * rinv * rinv;
+                const double dMd = M[0] * dx * dx + M[3] * dy * dy + M[5] * dz * dz
+                                   + 2.0 * (M[1] * dx * dy + M[2] * dx * dz + M[4] * dy * dz);
+                v[i] -= cell.charge * rinv + (P[0] * dx + P[1] * dy + P[2] * dz) * rinv3
+                        + 0.5 * (3.0 * dMd - trM * d2) * rinv3 * rinv * rinv;
+            }
+        }
+        else
+        {
+            // all points outside the smoothed regions: plain point charges
+            const bool unsmoothed = (dist - a > cell.rsmooth);
+            for (int j : cell.atoms)
+            {
+                const double xj = atoms[j].x, yj = atoms[j].y, zj = atoms[j].z;
+                const double q = atoms[j].q, rc = rcut[j];
+                for (int i = 0; i < npt; ++i)
+                {
+                    const double dx = x[i] - xj, dy = y[i] - yj, dz = z[i] - zj;
+                    r[i] = sqrt(dx * dx + dy * dy + dz * dz);
+                }
+                if (unsmoothed)
+                {
+                    for (int i = 0; i < npt; ++i) v[i] -= q / r[i];
+                }
+                else
+                {
+                    for (int i = 0; i < npt; ++i) v[i] -= q * smoothed_potential(r[i] * rc) * rc;
+                }
+            }
+        }
+    }
+}
+
 double Molecule::atomic_attraction_potential(int iatom, double x, double y,
                                              double z) const
 {
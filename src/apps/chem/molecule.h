@@ -210,6 +210,8 @@ public:
 
     std::vector<double> get_rcut() const {return rcut;}
 
+    const madness::Tensor<double>& get_field() const {return field;}
+
     void set_core_eprec(double value) {
         core_pot.set_eprec(value);
     }
@@ -311,6 +313,10 @@ public:
     /// nuclear attraction potential for the whole molecule
     double nuclear_attraction_potential(double x, double y, double z) const;
 
+    /// nuclear attraction potential for the whole molecule at npt points given by the arrays x, y and z
+    void nuclear_attraction_potential(const double* x, const double* y, const double* z,
+                                      double* v, int npt) const;
+
     /// nuclear attraction potential for a specific atom in the molecule
     double atomic_attraction_potential(int iatom, double x, double y, double z) const;
 
@@ -329,6 +335,56 @@ public:
     }
 };
 
+/// Cell list of the atoms of a molecule for sums over all atoms
+
+/// The atoms are sorted into cubic cells.  For a batch of points the
+/// contribution of a cell whose atoms are far from all points, and not
+/// within their smoothing radii, is computed from the multipole
+/// expansion of its charges (up to quadrupoles) about
+/// the cell center, provided the truncation error bound is below tol divided
+/// by the number of cells, so that the total error at any point is below tol;
+/// otherwise its atoms are summed explicitly, with the smoothed potential
+/// only for atoms close enough for the smoothing to matter.  With tol=0 the
+/// result is exact.  The cell list is a snapshot of the geometry at construction.
+class AtomCellList {
+    struct Cell {
+        std::vector<int> atoms;             ///< indices of the atoms in the cell
+        double center[3];                   ///< center of the cell
+        double radius;                      ///< largest distance of an atom from the center
+        double rsmooth;                     ///< largest radius of the smoothed region of an atom
+        double charge, abscharge;           ///< sum of the charges and of their absolute values
+        double dipole[3];                   ///< \sum_j q_j s_j, s_j = R_j - center
+        double quadrupole[6];               ///< \sum_j q_j s_j s_j^T, xx xy xz yy yz zz
+    };
+
+    double tol;
+    double celltol;                         ///< error budget of one far cell, tol/size()
+    std::vector<Atom> atoms;
+    std::vector<double> rcut;
+    double field[3];
+    std::vector<Cell> cells;
+
+public:
+    AtomCellList() : tol(0.0), celltol(0.0) {}
+
+    /// Sort the real atoms of molecule into cells of edge length width
+    AtomCellList(const Molecule& molecule, double tol, double width=4.0);
+
+    /// Number of occupied cells
+    std::size_t size() const {return cells.size();}
+
+    /// Nuclear attraction potential at npt points given by the arrays x, y and z
+    void nuclear_attraction_potential(const double* x, const double* y, const double* z,
+                                      double* v, int npt) const;
+
+    /// Nuclear attraction potential at a single point
+    double nuclear_attraction_potential(double x, double y, double z) const {
+        double v;
+        nuclear_attraction_potential(&x, &y, &z, &v, 1);
+        return v;
+    }
+};
+
 }
 
 #endif
@@ -10,6 +10,7 @@
 
 #include <cmath>
 #include <vector>
+#include <stdexcept>
 #include "polynomial.h"
 
 namespace slymer {
@@ -54,17 +54,29 @@
 namespace madness {
 class MolecularPotentialFunctor : public FunctionFunctorInterface<double, 3> {
  private:
-  const Molecule& molecule;
+  const AtomCellList cells;
+  const std::vector<coord_3d> specialpts;  ///< the atoms, from the same geometry as cells
 
  public:
-  MolecularPotentialFunctor(const Molecule& molecule) : molecule(molecule) {}
+  /// Distant atoms are treated by multipoles with a total error per point below tol (see AtomCellList)
+
+  /// Both the potential and the special points are snapshots of the
+  /// molecule at construction.
+  MolecularPotentialFunctor(const Molecule& molecule, double tol = 0.0)
+      : cells(molecule, tol), specialpts(molecule.get_all_coords_vec()) {}
 
   double operator()(const coord_3d& x) const {
-    return molecule.nuclear_attraction_potential(x[0], x[1], x[2]);
+    return cells.nuclear_attraction_potential(x[0], x[1], x[2]);
+  }
+
+  bool supports_vectorized() const { return true; }
+
+  void operator()(const Vector<double*, 3>& xvals, double* fvals, int npts) const {
+    cells.nuclear_attraction_potential(xvals[0], xvals[1], xvals[2], fvals, npts);
   }
 
   std::vector<coord_3d> special_points() const {
-    return molecule.get_all_coords_vec();
+    return specialpts;
   }
 };
 
@@ -219,7 +231,7 @@ class PotentialManager {
     double vtol = FunctionDefaults<3>::get_thresh() * safety;
     vnuc =
         real_factory_3d(world)
-            .functor(real_functor_3d(new MolecularPotentialFunctor(molecule)))
+            .functor(real_functor_3d(new MolecularPotentialFunctor(molecule, 0.01 * vtol)))
             .thresh(vtol)
             .truncate_on_project();
 
@@ -441,6 +441,7 @@ int exchange_anchor_test(World& world, Exchange<T,3>& K, const double thresh) {
 
     // compute the result functions with the exchange operator
     std::vector<Function<T,3> > Kamo1=K(amo);
+    print("exchange pairs computed/screened",K.pair_statistics().first,K.pair_statistics().second);
 
     std::vector<Function<T,3> > diff=sub(world,Kamo,Kamo1);
     std::vector<double> norms=norm2s(world,diff);
@@ -471,6 +472,45 @@ int exchange_anchor_test(World& world, Exchange<T,3>& K, const double thresh) {
     return 0;
 }
 
+/// exchange with orbitals far apart, so that the pair screening skips pairs
+
+/// the screened result must agree with the unscreened one to within thresh
+template<typename T>
+int exchange_screening_test(World& world, Exchange<T,3>& K, const double thresh) {
+
+    const int nmo=2;
+    std::vector<Function<T,3> > amo(nmo);
+    for (int i=0; i<nmo; ++i) {
+        Vector<double,3> origin(0.0);
+        origin[0]=(i==0) ? -6.0 : 6.0;
+        amo[i]=FunctionFactory<T,3>(world).truncate_on_project()
+                .functor(GaussianGuess<T,3>(origin,4.0)).thresh(thresh*0.1);
+    }
+    Tensor<double> aocc(nmo);
+    aocc.fill(1.0);
+    K.set_parameters(conj(world,amo),amo,aocc);
+
+    const double pair_tol=K.pair_tol();
+    K.pair_tol(0.0);
+    std::vector<Function<T,3> > Kref=K(amo);
+    K.pair_tol(pair_tol);
+    std::vector<Function<T,3> > Kamo=K(amo);
+    const long nscreened=K.pair_statistics().second;
+    print("exchange pairs computed/screened",K.pair_statistics().first,nscreened);
+    if (nscreened==0) {
+        print("no pairs screened");
+        return 1;
+    }
+
+    std::vector<double> norms=norm2s(world,sub(world,Kref,Kamo));
+    print("diffnorm in screened K",norms);
+    int ierr=0;
+    for (double& n : norms) {
+        if (check_err(n,thresh,"screened exchange error")) ierr++;
+    }
+    return ierr;
+}
+
 template<typename T>
 int test_exchange(World& world) {
 
@@ -504,6 +544,21 @@ int test_exchange(World& world) {
     if (typeid(T)==typeid(double)) success+=exchange_anchor_test(world, K, thresh);
     if (success>0) return 1;
 
+    // same with the fused algorithm
+    K.fused(true);
+    if (typeid(T)==typeid(double)) success+=exchange_anchor_test(world, K, thresh);
+    K.fused(false);
+    if (success>0) return 1;
+
+    // pairs skipped by the screening must not change the result
+    {
+        Exchange<T,3> Ks(world);
+        success+=exchange_screening_test(world, Ks, thresh);
+        Ks.fused(true);
+        success+=exchange_screening_test(world, Ks, thresh);
+        if (success>0) return 1;
+    }
+
     if (!smalltest) {
     	// test hermiticity of the K operator
     	success=test_hermiticity<T,Exchange<T,3> ,3>(world, K, thresh);
@@ -668,6 +723,54 @@ int nuclear_anchor_test(World& world) {
     return 0;
 }
 
+/// compare the nuclear potential from the cell list with the direct sum over atoms
+int atom_cell_list_test(World& world) {
+    Molecule molecule;
+    for (int i=0; i<8; ++i)
+        for (int j=0; j<8; ++j)
+            for (int k=0; k<8; ++k)
+                molecule.add_atom(3.0*i+0.1*j, 3.0*j+0.1*k, 3.0*k, 1.0+(i+j+k)%3, 1+(i+j+k)%3);
+
+    const double tol=1.e-6;
+    AtomCellList exact(molecule,0.0), cells(molecule,tol);
+    const int npt=100;
+    std::vector<double> x(npt), y(npt), z(npt), v0(npt), v1(npt);
+    for (int i=0; i<npt; ++i) {
+        x[i]=-40.0+0.9*i;
+        y[i]=10.0+0.05*i;
+        z[i]=11.0-0.1*i;
+    }
+    exact.nuclear_attraction_potential(&x[0],&y[0],&z[0],&v0[0],npt);
+    cells.nuclear_attraction_potential(&x[0],&y[0],&z[0],&v1[0],npt);
+
+    double err0=0.0, err1=0.0;
+    for (int i=0; i<npt; ++i) {
+        const double vref=molecule.nuclear_attraction_potential(x[i],y[i],z[i]);
+        err0=std::max(err0,fabs(v0[i]-vref));
+        err1=std::max(err1,fabs(v1[i]-vref));
+    }
+    print("atom cell list: cells, error exact, error far field",cells.size(),err0,err1);
+    if (check_err(err0,1.e-10,"cell list error")) return 1;
+    if (check_err(err1,tol,"cell list far-field error")) return 1;
+
+    // an atom at its cell center, with all points close to it but not on it:
+    // the multipole expansion is exact, but the potential must still be smoothed
+    Molecule atom;
+    atom.add_atom(2.0, 2.0, 2.0, 1.0, 1);
+    AtomCellList single(atom,tol);
+    for (int i=0; i<npt; ++i) {
+        x[i]=2.0+1.e-3*(i+1);
+        y[i]=z[i]=2.0;
+    }
+    single.nuclear_attraction_potential(&x[0],&y[0],&z[0],&v1[0],npt);
+    double err2=0.0;
+    for (int i=0; i<npt; ++i)
+        err2=std::max(err2,fabs(v1[i]-atom.nuclear_attraction_potential(x[i],y[i],z[i])));
+    print("atom cell list: error within the smoothing radius",err2);
+    if (check_err(err2,tol,"cell list smoothing error")) return 1;
+    return 0;
+}
+
 
 int test_nuclear(World& world) {
 
@@ -678,6 +781,7 @@ int test_nuclear(World& world) {
 
     int ierr=0;
     ierr+=nuclear_anchor_test(world);
+    ierr+=atom_cell_list_test(world);
     return ierr;
 }
 
@@ -856,6 +960,44 @@ int test_nemo(World& world) {
     return 0;
 }
 
+/// project atomic basis functions with project_functors, where the
+/// functors are screened in the boxes beyond the range of their shells
+int test_ao_projection(World& world) {
+    FunctionDefaults<3>::set_thresh(1.e-5);
+    double thresh=FunctionDefaults<3>::get_thresh();
+    if (world.rank()==0) print("\nentering test_ao_projection",thresh);
+    FunctionDefaults<3>::set_cubic_cell(-10, 10);
+
+    // a tight s and a p shell, range sqrt(27.6/2) and sqrt(27.6/3)
+    ContractedGaussianShell s(0,std::vector<double>(1,1.0),std::vector<double>(1,2.0));
+    ContractedGaussianShell p(1,std::vector<double>(1,1.0),std::vector<double>(1,3.0));
+    std::vector<AtomicBasisFunction> aos;
+    aos.push_back(AtomicBasisFunction(-5.0,0.0,0.0,s,0));
+    aos.push_back(AtomicBasisFunction(5.0,1.0,0.0,p,0));
+    aos.push_back(AtomicBasisFunction(5.0,1.0,0.0,p,2));
+
+    std::vector<std::shared_ptr<FunctionFunctorInterface<double,3> > > functors;
+    for (const AtomicBasisFunction& ao : aos) functors.push_back(
+            std::shared_ptr<FunctionFunctorInterface<double,3> >(new AtomicBasisFunctor(ao)));
+
+    // the box [0,10]^3 is out of range for the s function, not for the p functions
+    const coord_3d lo(0.0), hi(10.0);
+    if (not functors[0]->screened(lo,hi) or functors[1]->screened(lo,hi)) {
+        print("wrong screening of atomic basis functions");
+        return 1;
+    }
+
+    std::vector<real_function_3d> ao=project_functors(world,functors,real_factory_3d(world));
+    int ierr=0;
+    for (std::size_t i=0; i<functors.size(); ++i) {
+        real_function_3d ref=real_factory_3d(world).functor(functors[i]);
+        double err=(ref-ao[i]).norm2();
+        print("error in screened projection of ao",i,err);
+        if (check_err(err,thresh,"screened ao projection error")) ierr++;
+    }
+    return ierr;
+}
+
 int test_fock(World& world) {
     FunctionDefaults<3>::set_thresh(1.e-5);
     double thresh=FunctionDefaults<3>::get_thresh();
@@ -923,6 +1065,7 @@ int main(int argc, char** argv) {
     FunctionDefaults<3>::set_k(8); // needed for XC test to work
 
     int result=0;
+    result+=test_ao_projection(world);
     result+=test_fock(world);
     result+=test_kinetic<double,1>(world);
     result+=test_kinetic<double,2>(world);
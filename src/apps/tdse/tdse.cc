@@ -551,8 +551,10 @@ struct unaryexp {
 template<int NDIM>
 struct unaryexp<double_complex,NDIM> {
     void operator()(const Key<NDIM>& key, Tensor<double_complex>& t) const {
-        //vzExp(t.size, t.ptr(), t.ptr());
-        UNARY_OPTIMIZED_ITERATOR(double_complex, t, *_p0 = exp(*_p0););
+        if (t.iscontiguous())
+            vexp(t.size(), t.ptr(), t.ptr());
+        else
+            UNARY_OPTIMIZED_ITERATOR(double_complex, t, *_p0 = exp(*_p0););
     }
     template <typename Archive>
     void serialize(Archive& ar) {}
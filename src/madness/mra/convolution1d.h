@@ -39,6 +39,7 @@
 #include <madness/mra/simplecache.h>
 #include <madness/mra/adquad.h>
 #include <madness/mra/twoscale.h>
+#include <madness/mra/operator_block_store.h>
 #include <madness/tensor/aligned.h>
 #include <madness/tensor/tensor_lapack.h>
 #include <algorithm>
@@ -675,6 +676,8 @@ namespace madness {
     };
 
 
+    template <typename Q> struct GaussianConvolution1DCache;
+
     /// 1D convolution with (derivative) Gaussian; coeff and expnt given in *simulation* coordinates [0,1]
 
     /// Note that the derivative is computed in *simulation* coordinates so
@@ -737,10 +740,26 @@ namespace madness {
         /// \code
         /// beta = alpha * 2^(-2*n)
         /// \endcode
+        ///
+        /// For periodic operators the blocks are the lattice images of the
+        /// periodic sum.  They do not depend on the phase (k-point) of the
+        /// operator, so they are computed once and shared by all periodic
+        /// operators with the same kernel through GaussianConvolution1DCache.
         Tensor<Q> rnlp(Level n, Translation lx) const {
+            if (Convolution1D<Q>::maxR == 0) return compute_rnlp(n, lx);
+            return GaussianConvolution1DCache<Q>::get_image(*this, n, lx);
+        }
+
+        /// Computes the block of rnlp by quadrature
+        Tensor<Q> compute_rnlp(Level n, Translation lx) const {
             int twok = 2*this->k;
             Tensor<Q> v(twok);       // Can optimize this away by passing in
 
+            const bool store = OperatorBlockStore::enabled();
+            const OperatorBlockStore::keyT storekey(OperatorBlockStore::GAUSSIAN, this->k, this->npt, m,
+                                                    expnt, std::real(coeff), n, lx);
+            if (store && OperatorBlockStore::find(storekey, v)) return v;
+
             Translation lkeep = lx;
             if (lx<0) lx = -lx-1;
 
@@ -826,6 +845,7 @@ namespace madness {
                 for (long p=1; p<twok; p+=2) v(p) = -v(p);
             }
 
+            if (store) OperatorBlockStore::insert(storekey, v);
             return v;
         };
 
@@ -851,6 +871,85 @@ namespace madness {
         typedef typename ConcurrentHashMap<hashT, std::shared_ptr< GaussianConvolution1D<Q> > >::iterator iterator;
         typedef typename ConcurrentHashMap<hashT, std::shared_ptr< GaussianConvolution1D<Q> > >::datumT datumT;
 
+        /// Identifies a lattice image block by all parameters it depends on
+
+        /// The phase (k-point) of the operator is not part of the key since
+        /// the image blocks do not depend on it.
+        struct image_keyT {
+            double expnt;
+            Q coeff;
+            int k, npt, m;
+            Level n;
+            Translation lx;
+
+            image_keyT() : expnt(0.0), coeff(0.0), k(0), npt(0), m(0), n(0), lx(0) {}
+
+            image_keyT(const GaussianConvolution1D<Q>& op, Level n, Translation lx)
+                : expnt(op.expnt), coeff(op.coeff), k(op.k), npt(op.npt), m(op.m), n(n), lx(lx) {}
+
+            bool operator==(const image_keyT& other) const {
+                return expnt==other.expnt && coeff==other.coeff && k==other.k && npt==other.npt &&
+                    m==other.m && n==other.n && lx==other.lx;
+            }
+
+            hashT hash() const {
+                hashT h = hash_value(expnt);
+                hash_combine(h, std::real(coeff));
+                hash_combine(h, std::imag(coeff));
+                hash_combine(h, k);
+                hash_combine(h, npt);
+                hash_combine(h, m);
+                hash_combine(h, n);
+                hash_combine(h, lx);
+                return h;
+            }
+        };
+
+        /// Lattice images of periodic operators, shared by all phases (k-points)
+        typedef ConcurrentHashMap<image_keyT, Tensor<Q> > imagesT;
+        static imagesT images;
+        typedef typename imagesT::accessor image_accessor;
+
+        /// Largest number of image blocks kept; further blocks are recomputed on demand
+        static const std::size_t max_images = 1 << 16;
+
+        /// Returns (a copy of) the image block rnlp(n,lx) of a periodic operator
+
+        /// The first thread to request a block computes it, others wait for it.
+        static Tensor<Q> get_image(const GaussianConvolution1D<Q>& op, Level n, Translation lx) {
+            const image_keyT key(op, n, lx);
+
+            MADNESS_PRAGMA_CLANG(diagnostic push)
+            MADNESS_PRAGMA_CLANG(diagnostic ignored "-Wundefined-var-template")
+
+            image_accessor a;
+            if (images.size() < max_images) {
+                if (images.insert(a, key)) a->second = op.compute_rnlp(n, lx);
+                return copy(a->second);
+            }
+            if (images.find(a, key)) return copy(a->second);
+            return op.compute_rnlp(n, lx);
+
+            MADNESS_PRAGMA_CLANG(diagnostic pop)
+        }
+
+        /// Drops all shared operators and image blocks
+
+        /// Not thread safe; operators obtained from get() before remain valid.
+        static void clear() {
+            MADNESS_PRAGMA_CLANG(diagnostic push)
+            MADNESS_PRAGMA_CLANG(diagnostic ignored "-Wundefined-var-template")
+
+            map.clear();
+            images.clear();
+
+            MADNESS_PRAGMA_CLANG(diagnostic pop)
+        }
+
+        /// Returns the shared operator
+
+        /// Operators with a phase (k-point) are not kept here, since there may
+        /// be any number of them; they share only the image blocks.
         static std::shared_ptr< GaussianConvolution1D<Q> > get(int k, double expnt, int m, bool periodic) {
             hashT key = hash_value(expnt);
             hash_combine(key, k);
@@ -0,0 +1,93 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+
+#ifndef MADNESS_MRA_DATA_TABLE_H__INCLUDED
+#define MADNESS_MRA_DATA_TABLE_H__INCLUDED
+
+#include <cstdio>
+#include <cstddef>
+
+/// \file data_table.h
+/// \brief Sequential access to the numbers of the MRA data files or of their embedded copies
+
+namespace madness {
+
+    /// The data files coeffs, autocorr and gaussleg compiled into the library (see embed_data_table.cmake)
+    extern const double coeffs_table[];
+    extern const std::size_t coeffs_table_size;
+    extern const double autocorr_table[];
+    extern const std::size_t autocorr_table_size;
+    extern const double gaussleg_table[];
+    extern const std::size_t gaussleg_table_size;
+
+    /// Reads the whitespace separated numbers of a data file in order
+
+    /// The numbers come either from an open file or from the embedded copy
+    /// of the file, so the readers of the tables do not care which is used.
+    class DataTableReader {
+        FILE* file;
+        const double* p;
+        const double* end;
+
+    public:
+        /// Reads from file if it is open (it is closed by the destructor), otherwise from the n numbers of table
+        DataTableReader(FILE* file, const double* table, std::size_t n)
+            : file(file), p(table), end(table+n) {}
+
+        ~DataTableReader() {
+            if (file) fclose(file);
+        }
+
+        /// Returns false if there are no more numbers
+        bool read(double& x) {
+            if (file) return fscanf(file,"%lf",&x) == 1;
+            if (p == end) return false;
+            x = *p++;
+            return true;
+        }
+
+        /// Integer entries are stored exactly in the tables
+        bool read(long& i) {
+            double x;
+            if (!read(x)) return false;
+            i = long(x);
+            return true;
+        }
+
+    private:
+        DataTableReader(const DataTableReader&);
+        DataTableReader& operator=(const DataTableReader&);
+    };
+}
+
+#endif // MADNESS_MRA_DATA_TABLE_H__INCLUDED
@@ -234,6 +234,11 @@ namespace madness {
             return true;
         }
 
+        /// Boundary conditions of the operator
+        const BoundaryConditions<NDIM>& get_bc() const {
+            return bc;
+        }
+
         Key<NDIM> neighbor(const keyT& key, int step) const {
             Vector<Translation,NDIM> l = key.translation();
             l[axis] += step;
@@ -252,6 +257,9 @@ namespace madness {
                 return Future<argT>(argT(neigh,coeffT(vk,f->get_tensor_args()))); // Zero bc
             }
             else {
+                argT datum;
+                if (f->find_halo(neigh, datum)) return Future<argT>(datum);
+
                 Future<argT> result;
 		if (f->get_coeffs().is_local(neigh))
 		  f->send(f->get_coeffs().owner(neigh), &implT::sock_it_to_me, neigh, result.remote_ref(world));
@@ -723,6 +731,83 @@ namespace madness {
         return D(f,fence);
     }
 
+    /// Applies several derivative operators to one function in a single traversal of its tree
+
+    /// Returns the vector D[i] f, identical to applying each operator separately.
+    /// The left and right neighbors of each leaf in all directions are requested
+    /// together and one task per leaf produces all components, so the tree of f
+    /// is walked once instead of once per operator.  When fencing, the neighbors
+    /// are first gathered into a ghost layer with one exchange per process pair,
+    /// which is dropped again once the traversal has completed.  Without a fence
+    /// the ghost layer could not be dropped safely, so every neighbor is then
+    /// requested separately.
+    template <typename T, std::size_t NDIM>
+    std::vector< Function<T,NDIM> >
+    apply(const std::vector< std::shared_ptr< Derivative<T,NDIM> > >& D, const Function<T,NDIM>& f, bool fence=true) {
+        if (VERIFY_TREE) f.verify_tree();
+
+        if (f.is_compressed()) {
+            if (fence) {
+                f.reconstruct();
+            }
+            else {
+                MADNESS_EXCEPTION("diff: trying to diff a compressed function without fencing",0);
+            }
+        }
+
+        std::vector< Function<T,NDIM> > df(D.size());
+        if (D.empty()) return df;
+        MADNESS_ASSERT(!f.get_impl()->has_halo());
+        if (fence) f.get_impl()->make_halo(D[0]->get_bc(), true);
+        std::vector<const DerivativeBase<T,NDIM>*> ops(D.size());
+        std::vector<FunctionImpl<T,NDIM>*> impls(D.size());
+        for (std::size_t i=0; i<D.size(); ++i) {
+            df[i].set_impl(f,false);
+            ops[i] = D[i].get();
+            impls[i] = df[i].get_impl().get();
+        }
+        impls[0]->diff_multi(ops, f.get_impl().get(), impls, fence);
+        if (fence) f.get_impl()->clear_halo();
+        return df;
+    }
+
+    /// Applies several derivative operators to each function of a vector
+
+    /// Returns df[i][j] = D[i] v[j], see apply() above.  The ghost layers of
+    /// all functions are gathered under a single fence and dropped once all
+    /// traversals have completed, so the batch always fences.
+    template <typename T, std::size_t NDIM>
+    std::vector< std::vector< Function<T,NDIM> > >
+    apply_derivatives(World& world, const std::vector< std::shared_ptr< Derivative<T,NDIM> > >& D,
+                      const std::vector< Function<T,NDIM> >& v) {
+        std::vector< std::vector< Function<T,NDIM> > > df(D.size(), std::vector< Function<T,NDIM> >(v.size()));
+        if (D.empty() || v.empty()) return df;
+
+        for (std::size_t j=0; j<v.size(); ++j) {
+            if (v[j].is_compressed()) v[j].reconstruct(false);
+        }
+        world.gop.fence();
+        for (std::size_t j=0; j<v.size(); ++j) {
+            // the same function may appear more than once
+            if (!v[j].get_impl()->has_halo()) v[j].get_impl()->make_halo(D[0]->get_bc(), false);
+        }
+        world.gop.fence();
+
+        std::vector<const DerivativeBase<T,NDIM>*> ops(D.size());
+        for (std::size_t i=0; i<D.size(); ++i) ops[i] = D[i].get();
+        for (std::size_t j=0; j<v.size(); ++j) {
+            std::vector<FunctionImpl<T,NDIM>*> impls(D.size());
+            for (std::size_t i=0; i<D.size(); ++i) {
+                df[i][j].set_impl(v[j],false);
+                impls[i] = df[i][j].get_impl().get();
+            }
+            impls[0]->diff_multi(ops, v[j].get_impl().get(), impls, false);
+        }
+        world.gop.fence();
+        for (std::size_t j=0; j<v.size(); ++j) v[j].get_impl()->clear_halo();
+        return df;
+    }
+
     /// Convenience function returning vector of derivative operators implementing grad (\f$ \nabla \f$)
 
     /// This will only work for BC_ZERO, BC_PERIODIC, BC_FREE and
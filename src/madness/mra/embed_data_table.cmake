@@ -0,0 +1,22 @@
+# Converts the whitespace separated numbers of an MRA data file into a C++
+# array so that the library does not need to read the file at startup.
+#
+# usage: cmake -DINPUT=<data file> -DNAME=<array name> -DOUTPUT=<source file> -P embed_data_table.cmake
+
+file(READ "${INPUT}" _data)
+string(STRIP "${_data}" _data)
+string(REGEX REPLACE "[ \t\r\n]+" ",\n" _data "${_data}")
+get_filename_component(_input_name "${INPUT}" NAME)
+
+file(WRITE "${OUTPUT}"
+"// Generated from ${_input_name} by embed_data_table.cmake ... do not edit
+
+#include <cstddef>
+
+namespace madness {
+    extern const double ${NAME}[] = {
+${_data}
+    };
+    extern const std::size_t ${NAME}_size = sizeof(${NAME})/sizeof(double);
+}
+")
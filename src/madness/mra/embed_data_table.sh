@@ -0,0 +1,19 @@
+#!/bin/sh
+# Converts the whitespace separated numbers of an MRA data file into a C++
+# array, as embed_data_table.cmake does for the CMake build.
+#
+# usage: embed_data_table.sh <data file> <array name> > <source file>
+
+input=$1
+name=$2
+
+echo "// Generated from `basename $input` by embed_data_table.sh ... do not edit"
+echo ""
+echo "#include <cstddef>"
+echo ""
+echo "namespace madness {"
+echo "    extern const double ${name}[] = {"
+tr -s ' \t\r\n' '\n\n\n\n' < "$input" | sed -e '/^$/d' -e '$!s/$/,/'
+echo "    };"
+echo "    extern const std::size_t ${name}_size = sizeof(${name})/sizeof(double);"
+echo "}"
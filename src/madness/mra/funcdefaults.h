@@ -185,6 +185,7 @@ namespace madness {
         static bool truncate_on_project; ///< If true initial projection inserts at n-1 not n
         static bool apply_randomize;   ///< If true use randomization for load balancing in apply integral operator
         static bool project_randomize; ///< If true use randomization for load balancing in project/refine
+        static bool lazy_accumulation; ///< If true low rank results of apply are appended and reduced at the end or when the buffer exceeds its rank cap
         static BoundaryConditions<NDIM> bc; ///< Default boundary conditions
         static Tensor<double> cell ;   ///< cell[NDIM][2] Simulation cell, cell(0,0)=xlo, cell(0,1)=xhi, ...
         static Tensor<double> cell_width;///< Width of simulation cell in each dimension
@@ -360,6 +361,21 @@ namespace madness {
             project_randomize=value;
         }
 
+        /// Gets the lazy accumulation flag for low rank results of apply
+        static bool get_lazy_accumulation() {
+            return lazy_accumulation;
+        }
+
+        /// Sets the lazy accumulation flag for low rank results of apply
+
+        /// If set, the low rank contributions of apply to a node are appended
+        /// to its buffer without rank reduction, and the buffer is reduced in
+        /// a single pass in finalize_apply.  This needs more memory but much
+        /// fewer SVDs than reducing the rank after each contribution.
+        static void set_lazy_accumulation(bool value) {
+            lazy_accumulation=value;
+        }
+
         /// Returns the default boundary conditions
         static const BoundaryConditions<NDIM>& get_bc() {
             return bc;
@@ -37,6 +37,7 @@
 
 #include <iostream>
 #include <type_traits>
+#include <limits>
 #include <madness/world/MADworld.h>
 #include <madness/world/print.h>
 #include <madness/misc/misc.h>
@@ -134,8 +135,12 @@ namespace madness {
         double _norm_tree; ///< After norm_tree will contain norm of coefficients summed up tree
         bool _has_children; ///< True if there are children
         coeffT buffer; ///< The coefficients, if any
+        long buffer_rank=0; ///< rank of the buffer after its last reduction
 
     public:
+        /// rank the lazy buffer may reach before it is reduced, unless twice its last reduced rank is larger
+        static constexpr long lazy_rank_budget=64;
+
         typedef WorldContainer<Key<NDIM> , FunctionNode<T, NDIM> > dcT; ///< Type of container holding the nodes
         /// Default constructor makes node without coeff or children
         FunctionNode() :
@@ -359,7 +364,17 @@ namespace madness {
         double accumulate(const coeffT& t, const typename FunctionNode<T,NDIM>::dcT& c,
                           const Key<NDIM>& key, const TensorArgs& args) {
             double cpu0=cpu_time();
-            if (has_coeff()) {
+            if (FunctionDefaults<NDIM>::get_lazy_accumulation() and (t.tensor_type()==TT_2D)) {
+                const bool is_new=not (has_coeff() or buffer.has_data());
+                accumulate_lazy(t,args);
+                if (is_new and (!_has_children) && key.level()> 0) {
+                    Key<NDIM> parent = key.parent();
+                    if (c.is_local(parent))
+                        const_cast<dcT&>(c).send(parent, &FunctionNode<T,NDIM>::set_has_children_recursive, c, parent);
+                    else
+                        const_cast<dcT&>(c).task(parent, &FunctionNode<T,NDIM>::set_has_children_recursive, c, parent);
+                }
+            } else if (has_coeff()) {
 
 #if 1
                 coeff().add_SVD(t,args.thresh);
@@ -395,13 +410,41 @@ namespace madness {
             return cpu1-cpu0;
         }
 
+        /// Append t to the buffer without reducing the rank
+
+        /// The buffer is reduced once its rank exceeds the larger of
+        /// lazy_rank_budget and twice its rank after the last reduction, but
+        /// never more than the rank of a full tensor (k^(NDIM/2)).  The
+        /// buffer thus stays within a small multiple of the rank of the
+        /// result; without the cap it could grow to twice the full rank,
+        /// i.e. 2*k^3 configurations of 2*k^3 numbers each in 6D.
+        void accumulate_lazy(const coeffT& t, const TensorArgs& args) {
+            if (buffer.has_data()) buffer+=t;
+            else buffer=copy(t);
+
+            long maxrank=1;
+            for (long i=0; i<buffer.ndim()/2; ++i) maxrank*=buffer.dim(i);
+            const long cap=std::min(maxrank,std::max(lazy_rank_budget,2*buffer_rank));
+            if (buffer.rank()>cap) {
+                buffer.orthonormalize(args.thresh);
+                buffer_rank=buffer.rank();
+            }
+        }
+
         void consolidate_buffer(const TensorArgs& args) {
-            if ((coeff().has_data()) and (buffer.has_data())) {
+            if (FunctionDefaults<NDIM>::get_lazy_accumulation() and (buffer.tensor_type()==TT_2D)
+                and ((not coeff().has_data()) or (coeff().tensor_type()==TT_2D))) {
+                // the buffer is not orthonormal: reduce everything at once
+                if (coeff().has_data()) buffer+=coeff();
+                buffer.orthonormalize(args.thresh);
+                coeff()=buffer;
+            } else if ((coeff().has_data()) and (buffer.has_data())) {
                 coeff().add_SVD(buffer,args.thresh);
             } else if (buffer.has_data()) {
                 coeff()=buffer;
             }
             buffer=coeffT();
+            buffer_rank=0;
         }
 
         T trace_conj(const FunctionNode<T,NDIM>& rhs) const {
@@ -883,6 +926,10 @@ namespace madness {
 
         dcT coeffs; ///< The coefficients
 
+        /// Ghost layer of neighbor nodes gathered by make_halo, keyed by the requested key
+        typedef ConcurrentHashMap< keyT, std::pair<keyT,coeffT> > haloT;
+        std::shared_ptr<haloT> halo;
+
         // Disable the default copy constructor
         FunctionImpl(const FunctionImpl<T,NDIM>& p);
 
@@ -1508,6 +1555,14 @@ namespace madness {
         /// @param[in] key the key to the current function node (box)
         tensorT project(const keyT& key) const;
 
+        /// Compute by projection the scaling function coeffs of all children of a box
+
+        /// Functors supporting vectorized evaluation are called once with the
+        /// quadrature points of all children.
+        /// @param[in] key the key to the parent box
+        /// @return the children's coefficients arranged as in a 2k^NDIM tensor (see child_patch)
+        tensorT project_children(const keyT& key) const;
+
         /// Returns the truncation threshold according to truncate_method
 
         /// here is our handwaving argument:
@@ -1531,6 +1586,26 @@ namespace madness {
         void project_refine_op(const keyT& key, bool do_refine,
                                const std::vector<Vector<double,NDIM> >& specialpts);
 
+        /// Projection of many functions with refinement in one traversal of a shared tree
+
+        /// Every function in v carries its own functor and gets its own tree,
+        /// but all are refined together box by box.  A function whose functor
+        /// is screened in a box becomes a zero leaf there, so that functions are
+        /// only evaluated in boxes they overlap.  Invoked on v[0].
+        /// @param[in] key the key to the current box
+        /// @param[in] v the empty functions to be projected, all with the same process map
+        /// @param[in] active the indices of the functions that are refined below the parent
+        /// @param[in] specialpts the special points of the active functions, restricted to
+        ///            the neighborhood of the parent
+        void project_refine_multi_op(const keyT& key, const std::vector<implT*>& v,
+                                     const std::vector<int>& active,
+                                     const std::vector<std::vector<coordT> >& specialpts);
+
+        /// Projects the functors of the empty functions in v with project_refine_multi_op()
+
+        /// Invoked on v[0] by all processes.
+        void project_multi(const std::vector<implT*>& v, bool fence);
+
         /// Compute the Legendre scaling functions for multiplication
 
         /// Evaluate parent polyn at quadrature points of a child.  The prefactor of
@@ -1791,9 +1866,10 @@ namespace madness {
             Tensor<L> lcube = fcube_for_mul(key, key, left);
 
             Tensor<T> tcube(cdata.vk,false);
-            TERNARY_OPTIMIZED_ITERATOR(T, tcube, L, lcube, R, rcube, *_p0 = *_p1 * *_p2;);
+            // scale in the same pass as the product
             double scale = pow(0.5,0.5*NDIM*key.level())*sqrt(FunctionDefaults<NDIM>::get_cell_volume());
-            tcube = transform(tcube,cdata.quad_phiw).scale(scale);
+            TERNARY_OPTIMIZED_ITERATOR(T, tcube, L, lcube, R, rcube, *_p0 = scale * *_p1 * *_p2;);
+            tcube = transform(tcube,cdata.quad_phiw);
             coeffs.replace(key, nodeT(coeffT(tcube,targs),false));
         }
 
@@ -1819,10 +1895,10 @@ namespace madness {
 
             // it's sufficient to scale once
             double scale = pow(2.0,0.5*NDIM*key.level())/sqrt(FunctionDefaults<NDIM>::get_cell_volume());
-            Tensor<T> c1value=transform(c11,cdata2.quad_phit).scale(scale);
+            Tensor<T> c1value=transform(c11,cdata2.quad_phit);
             Tensor<R> c2value=transform(c22,cdata2.quad_phit);
             Tensor<resultT> resultvalue(cdata2.vk,false);
-            TERNARY_OPTIMIZED_ITERATOR(resultT, resultvalue, T, c1value, R, c2value, *_p0 = *_p1 * *_p2;);
+            TERNARY_OPTIMIZED_ITERATOR(resultT, resultvalue, T, c1value, R, c2value, *_p0 = scale * *_p1 * *_p2;);
 
             Tensor<resultT> result=transform(resultvalue,cdata2.quad_phiw);
 
@@ -1944,16 +2020,15 @@ namespace madness {
 			MADNESS_ASSERT(maxk==g_coeff.dim(0));
 
 			// get tensors for particle 1 and 2 (U and V in SVD)
-			tensorT vec1=copy(g_values.config().ref_vector(0).reshape(rank,maxk,maxk,maxk));
+			tensorT vec1=g_values.config().ref_vector(0).reshape(rank,maxk,maxk,maxk);
 			tensorT vec2=g_values.config().ref_vector(1).reshape(rank,maxk,maxk,maxk);
 			tensorT result(maxk,maxk,maxk);  // should give zero tensor
 			// Multiply the values of each U and V vector
 			for (long i=0; i<rank; ++i) {
 				tensorT c1=vec1(Slice(i,i),_,_,_); // shallow copy (!)
 				tensorT c2=vec2(Slice(i,i),_,_,_);
-				c1.emul(c2); // this changes vec1 because of shallow copy, but not the g function because of the deep copy made above
 				double singular_value_i = g_values.config().weights(i);
-				result += (singular_value_i*c1);
+				result.gaxpy_emul(1.0,singular_value_i,c1,c2); // leaves vec1 and the g function unchanged
 			}
 
 			// accumulate coefficients (since only diagonal boxes are used the coefficients get just replaced, but accumulate is needed to create the right tree structure
@@ -2620,18 +2695,142 @@ namespace madness {
             if (fence) world.gop.fence();
         }
 
+        /// Transforms the coefficients of all input functions at the keys in [lstart,lend)
+
+        /// At each key the coefficients of the input functions present there
+        /// are the rows of a matrix that is multiplied by a block of
+        /// columns of \c c at a time.  A block is skipped for the inputs
+        /// whose norm times the largest element of \c c in the block
+        /// (\c cmax) is below the truncation tolerance, and within a block
+        /// each (input,output) pair is screened as in vtransform_doit.
+        /// The iterators point into \c rmap , which refers to the
+        /// coefficients of \c vright ; the task holds both so that the caller
+        /// need not wait for it.
+        template <typename Q, typename R>
+        void vtransform_block(const std::shared_ptr<typename FunctionImpl<R,NDIM>::mapT>& rmap,
+                              const std::vector< std::shared_ptr< FunctionImpl<R,NDIM> > >& vright,
+                              const typename FunctionImpl<R,NDIM>::mapT::iterator lstart,
+                              const typename FunctionImpl<R,NDIM>::mapT::iterator lend,
+                              const Tensor<Q>& c,
+                              const Tensor<double>& cmax,
+                              const std::vector< std::shared_ptr< FunctionImpl<T,NDIM> > >& vleft,
+                              double tol) {
+            typedef typename FunctionImpl<R,NDIM>::mapvecT mapvecR;
+            const long m = c.dim(1);
+            const long nblock = cmax.dim(1);
+            const long bsize = (m-1)/nblock + 1;
+
+            for (typename FunctionImpl<R,NDIM>::mapT::iterator it=lstart; it!=lend; ++it) {
+                const Key<NDIM>& key = it->first;
+                const mapvecR& in = it->second;
+                const double keytol = truncate_tol(tol,key);
+                const long size = in[0].second->size();
+
+                std::vector<double> norm(in.size());
+                for (std::size_t jj=0; jj<in.size(); ++jj) norm[jj] = in[jj].second->normf();
+
+                for (long b=0; b<nblock; ++b) {
+                    const long ilo = b*bsize;
+                    const long nb = std::min(bsize, m-ilo);
+
+                    std::vector<std::size_t> sel;
+                    for (std::size_t jj=0; jj<in.size(); ++jj) {
+                        if (norm[jj]*cmax(in[jj].first,b) > keytol) sel.push_back(jj);
+                    }
+                    if (sel.empty()) continue;
+
+                    Tensor<T> cblock(long(sel.size()), nb);
+                    std::vector<bool> touched(nb, false);
+                    for (std::size_t s=0; s<sel.size(); ++s) {
+                        const long j = in[sel[s]].first;
+                        for (long ii=0; ii<nb; ++ii) {
+                            const Q cji = c(j,ilo+ii);
+                            if (std::abs(norm[sel[s]]*cji) > keytol) {
+                                cblock(s,ii) = cji;
+                                touched[ii] = true;
+                            }
+                        }
+                    }
+
+                    Tensor<T> input(long(sel.size()), size);
+                    for (std::size_t s=0; s<sel.size(); ++s) input(s,_) = in[sel[s]].second->full_tensor();
+                    Tensor<T> result(nb, size);
+                    mTxm(nb, size, long(sel.size()), result.ptr(), cblock.ptr(), input.ptr());
+
+                    for (long ii=0; ii<nb; ++ii) {
+                        if (!touched[ii]) continue;
+                        implT* left = vleft[ilo+ii].get();
+                        typename dcT::accessor acc;
+                        bool newnode = left->coeffs.insert(acc,key);
+                        if (newnode && key.level()>0) {
+                            Key<NDIM> parent = key.parent();
+                            if (left->coeffs.is_local(parent))
+                                left->coeffs.send(parent, &nodeT::set_has_children_recursive, left->coeffs, parent);
+                            else
+                                left->coeffs.task(parent, &nodeT::set_has_children_recursive, left->coeffs, parent);
+                        }
+                        nodeT& node = acc->second;
+                        if (!node.has_coeff())
+                            node.set_coeff(coeffT(cdata.v2k,targs));
+                        Tensor<T>& t = node.coeff().full_tensor();
+                        MADNESS_ASSERT(t.iscontiguous() && t.size() == size);
+                        T* MADNESS_RESTRICT p = t.ptr();
+                        const T* MADNESS_RESTRICT q = result.ptr() + ii*size;
+                        for (long k=0; k<size; ++k) p[k] += q[k];
+                    }
+                }
+            }
+        }
+
         /// Transforms a vector of functions left[i] = sum[j] right[j]*c[j,i] using sparsity
         /// @param[in] vright vector of functions (impl's) on which to be transformed
         /// @param[in] c the tensor (matrix) transformer
         /// @param[in] vleft vector of of the *newly* transformed functions (impl's)
+
+        /// With full-rank coefficients the input coefficients at each box
+        /// are transformed together by vtransform_block with one matrix
+        /// product per block of outputs, instead of one gaxpy per
+        /// (input,output) pair.  Low-rank coefficients are transformed one
+        /// input function at a time by vtransform_doit.
         template <typename Q, typename R>
         void vtransform(const std::vector< std::shared_ptr< FunctionImpl<R,NDIM> > >& vright,
                         const Tensor<Q>& c,
                         const std::vector< std::shared_ptr< FunctionImpl<T,NDIM> > >& vleft,
                         double tol,
                         bool fence) {
-            for (unsigned int j=0; j<vright.size(); ++j) {
-                world.taskq.add(*this, &implT:: template vtransform_doit<Q,R>, vright[j], copy(c(j,_)), vleft, tol);
+            bool full = (targs.tt == TT_FULL);
+            for (unsigned int j=0; j<vright.size(); ++j) full = full && (vright[j]->get_tensor_args().tt == TT_FULL);
+
+            if (!full || vright.empty() || vleft.empty()) {
+                for (unsigned int j=0; j<vright.size(); ++j) {
+                    world.taskq.add(*this, &implT:: template vtransform_doit<Q,R>, vright[j], copy(c(j,_)), vleft, tol);
+                }
+            }
+            else {
+                // Largest element of c in each block of at most 64 outputs, for screening whole blocks
+                const long n = c.dim(0), m = c.dim(1);
+                const long nblock = (m-1)/64 + 1;
+                const long bsize = (m-1)/nblock + 1;
+                Tensor<double> cmax(n, nblock);
+                for (long j=0; j<n; ++j) {
+                    for (long i=0; i<m; ++i) {
+                        cmax(j,i/bsize) = std::max(cmax(j,i/bsize), double(std::abs(c(j,i))));
+                    }
+                }
+
+                std::vector<const FunctionImpl<R,NDIM>*> right(vright.size());
+                for (unsigned int j=0; j<vright.size(); ++j) right[j] = vright[j].get();
+                std::shared_ptr<typename FunctionImpl<R,NDIM>::mapT> rmap(
+                    new typename FunctionImpl<R,NDIM>::mapT(FunctionImpl<R,NDIM>::make_key_vec_map(right)));
+
+                size_t chunk = (rmap->size()-1)/(3*4*5)+1;
+                typename FunctionImpl<R,NDIM>::mapT::iterator lstart=rmap->begin();
+                while (lstart != rmap->end()) {
+                    typename FunctionImpl<R,NDIM>::mapT::iterator lend = lstart;
+                    advance(lend,chunk);
+                    world.taskq.add(*this, &implT:: template vtransform_block<Q,R>, rmap, vright, lstart, lend, c, cmax, vleft, tol);
+                    lstart = lend;
+                }
             }
             if (fence)
                 world.gop.fence();
@@ -2908,6 +3107,79 @@ namespace madness {
             }
         }
 
+        /// Out of place operation on the values of many functions using recursive descent
+
+        /// In contrast to multiop_values() the inputs need not be refined to a
+        /// common level: coefficients of inputs that end above the current box
+        /// are projected down on the fly, so the result is formed on the union
+        /// of the input trees in a single traversal. Assumes same distribution.
+        /// If \c autorefine is set, a box is also subdivided where an operand
+        /// with the autorefine flag fails the squaring test, so that products
+        /// are not formed on boxes too coarse for them; the operands are not
+        /// modified.
+        /// @param[in] key the key to the current function node (box)
+        /// @param[in] v the function impl's of the operands
+        /// @param[in] cin the scaling function coefficients of the operands in
+        ///            the current box if known from the parent, empty otherwise
+        /// @param[in] op the operator acting on the values, cf multiop_values()
+        /// @param[in] autorefine refine on the fly for autorefining operands
+        template <typename opT>
+        void multiopXXa(const keyT& key, const std::vector<const implT*>& v,
+                        const std::vector<tensorT>& cin, const opT& op,
+                        bool autorefine) {
+            typedef typename dcT::const_iterator citerT;
+
+            std::vector<tensorT> c(cin);
+            bool leaf = true;
+            for (std::size_t i=0; i<v.size(); ++i) {
+                if (c[i].size() == 0) {
+                    citerT it = v[i]->coeffs.find(key).get();
+                    MADNESS_ASSERT(it != v[i]->coeffs.end());
+                    if (it->second.has_coeff())
+                        c[i] = it->second.coeff().full_tensor_copy();
+                }
+                if (c[i].size() == 0) leaf = false;
+            }
+
+            if (leaf && autorefine && key.level() < max_refine_level) {
+                for (std::size_t i=0; i<v.size() && leaf; ++i) {
+                    if (!v[i]->get_autorefine()) continue;
+                    double lo, hi;
+                    v[i]->tnorm(c[i], &lo, &hi);
+                    if (2*lo*hi + hi*hi > v[i]->truncate_tol(v[i]->get_thresh(), key)) leaf = false;
+                }
+            }
+
+            if (leaf) {
+                std::vector<tensorT> values(v.size());
+                for (std::size_t i=0; i<v.size(); ++i) values[i] = coeffs2values(key, c[i]);
+                tensorT r = op(key, values);
+                coeffs.replace(key, nodeT(coeffT(values2coeffs(key, r),targs),false));
+                return;
+            }
+
+            // Recur down
+            coeffs.replace(key, nodeT(coeffT(),true)); // Interior node
+
+            std::vector<tensorT> ss(v.size());
+            for (std::size_t i=0; i<v.size(); ++i) {
+                if (c[i].size()) {
+                    tensorT d(cdata.v2k);
+                    d(cdata.s0) = c[i](___);
+                    ss[i] = v[i]->unfilter(d);
+                }
+            }
+
+            for (KeyChildIterator<NDIM> kit(key); kit; ++kit) {
+                const keyT& child = kit.key();
+                std::vector<tensorT> cc(v.size());
+                for (std::size_t i=0; i<v.size(); ++i) {
+                    if (ss[i].size()) cc[i] = copy(ss[i](child_patch(child)));
+                }
+                woT::task(coeffs.owner(child), &implT:: template multiopXXa<opT>, child, v, cc, op, autorefine);
+            }
+        }
+
         template <typename Q, typename opT>
         struct coeff_value_adaptor {
             typedef typename opT::resultT resultT;
@@ -2991,6 +3263,19 @@ namespace madness {
             //verify_tree();
         }
 
+        /// Performs an operation on the values of many functions (impl's). Delegates to the multiopXXa() method
+        /// @param[in] v pointers to the reconstructed function impl's of the operands
+        /// @param[in] op the operator acting on the values, cf multiop_values()
+        /// @param[in] autorefine refine on the fly where autorefining operands need it
+        template <typename opT>
+        void multiopXX(const std::vector<const implT*>& v, const opT& op, bool fence,
+                       bool autorefine=false) {
+            if (world.rank() == coeffs.owner(cdata.key0))
+                multiopXXa(cdata.key0, v, std::vector<tensorT>(v.size()), op, autorefine);
+            if (fence)
+                world.gop.fence();
+        }
+
         /// Performs unary operation on function impl. Delegates to the unaryXXa() method
         /// @param[in] func function impl of the operand
         /// @param[in] op the unary operator
@@ -3082,6 +3367,39 @@ namespace madness {
         void sock_it_to_me_too(const keyT& key,
                                const RemoteReference< FutureImpl< std::pair<keyT,coeffT> > >& ref) const;
 
+        /// Gathers the face neighbors of all local leaves into a read-only ghost layer
+
+        /// Each process sends a single request to every owner of neighbors it
+        /// needs, and the owner answers with what sock_it_to_me would return for
+        /// each box.  Neighbors across a periodic boundary of bc are wrapped.
+        /// Afterwards find_halo answers neighbor lookups locally.  The halo is
+        /// not updated when the function changes; it is only built for the
+        /// duration of a fenced derivative, see apply() in derivative.h.
+        void make_halo(const BoundaryConditions<NDIM>& bc, bool fence);
+
+        /// Drops the ghost layer
+        void clear_halo() {
+            halo.reset();
+        }
+
+        /// Returns true if the ghost layer is present
+        bool has_halo() const {
+            return bool(halo);
+        }
+
+        /// Looks up key in the ghost layer; returns false if it was not gathered
+        bool find_halo(const keyT& key, std::pair<keyT,coeffT>& datum) const;
+
+        /// Answers a halo request with the datum of each key (see sock_it_to_me)
+        Future< std::vector< std::pair<keyT,coeffT> > > get_halo(const std::vector<keyT>& keys);
+
+        /// Collects the data of get_halo once all are available
+        std::vector< std::pair<keyT,coeffT> >
+        get_halo_gather(const std::vector< Future< std::pair<keyT,coeffT> > >& v) const;
+
+        /// Stores the answer to a halo request in the ghost layer
+        void put_halo(const std::vector<keyT>& keys, const std::vector< std::pair<keyT,coeffT> >& data);
+
         /// @todo help!
         void plot_cube_kernel(archive::archive_ptr< Tensor<T> > ptr,
                               const keyT& key,
@@ -3116,6 +3434,25 @@ namespace madness {
                   const keyT& keyin,
                   const typename Future<T>::remote_refT& ref);
 
+        /// Evaluate the function at many points in \em simulation coordinates
+
+        /// The points are sorted into the children of key on the way down the
+        /// tree, each batch travelling in one message to the owner of the box.
+        /// The result is returned in the order of the input points.
+        /// @param[in] key the box containing all points x
+        /// @param[in] x the points in simulation coordinates
+        Future< std::vector<T> > eval_batch(const keyT& key, const std::vector<coordT>& x);
+
+        /// Evaluate the coefficients c of box key at the points x in \em simulation coordinates
+
+        /// All points are contracted with the Legendre scaling functions at once;
+        /// no communication.
+        std::vector<T> eval_points(const keyT& key, const std::vector<coordT>& x, const tensorT& c) const;
+
+        /// Collect the results of the children in eval_batch into the original order
+        std::vector<T> eval_batch_gather(const std::vector<int>& which,
+                                         const std::vector< Future< std::vector<T> > >& v) const;
+
         /// Get the depth of the tree at a point in \em simulation coordinates
 
         /// Only the invoking process will get the result via the
@@ -3618,6 +3955,21 @@ namespace madness {
         // Called by result function to differentiate f
         void diff(const DerivativeBase<T,NDIM>* D, const implT* f, bool fence);
 
+        void do_diff_multi(const std::vector<const DerivativeBase<T,NDIM>*>& D,
+                           const implT* f,
+                           const std::vector<implT*>& df,
+                           const keyT& key,
+                           const std::vector< Future< std::pair<keyT,coeffT> > >& left,
+                           const std::pair<keyT,coeffT>& center,
+                           const std::vector< Future< std::pair<keyT,coeffT> > >& right);
+
+        /// Called by the first result function to apply several derivatives to f in one traversal
+
+        /// df[i] receives D[i] f.  The neighbors of a leaf in all directions are
+        /// requested together and a single task per leaf handles all components.
+        void diff_multi(const std::vector<const DerivativeBase<T,NDIM>*>& D, const implT* f,
+                        const std::vector<implT*>& df, bool fence);
+
         /// Returns key of general neighbor enforcing BC
 
         /// Out of volume keys are mapped to enforce the BC as follows.
@@ -4218,6 +4570,15 @@ namespace madness {
 
         Future<double> norm_tree_spawn(const keyT& key);
 
+        /// local contributions to the norms of the function in all boxes of level n
+
+        /// Requires norm_tree(). Leaves above level n contribute their full
+        /// norm to each of their descendants, so the result is an upper bound.
+        /// Boxes are numbered with the last dimension running fastest.
+        /// @param[in]  n       the level of the boxes, 2^(n*NDIM) must be small
+        /// @param[out] norms   1D tensor of size 2^(n*NDIM), local entries are set
+        void local_box_norms(const int n, Tensor<double>& norms) const;
+
         /// truncate using a tree in reconstructed form
 
         /// must be invoked where key is local
@@ -4447,6 +4808,16 @@ namespace madness {
             double fac = vol_nsphere(NDIM, radius);
             //previously fac=10.0 selected empirically constrained by qmprop
 
+            // the adaptive mode learns how far earlier applications reached;
+            // beyond that distance the loop stops at the first displacement
+            // that fails the norm bound instead of after a whole empty shell
+            const Level n = key.level();
+            unsigned long maxdistsq = std::numeric_limits<unsigned long>::max();
+            if (op->adaptive_cutoff()) op->get_cutoff(n, maxdistsq);
+
+            // counted locally and flushed once per source box
+            unsigned long nconsidered=0, nscreened=0, napplied=0, ndiscarded=0, maxdistsq_kept=0;
+
             double cnorm = c.normf();
 
             const std::vector<opkeyT>& disp = op->get_disp(key.level()); // list of displacements sorted in orer of increasing distance
@@ -4476,19 +4847,30 @@ namespace madness {
                 if (dest.is_valid()) {
                     double opnorm = op->norm(key.level(), *it, source);
                     double tol = truncate_tol(thresh, key);
+                    nconsidered++;
 
                     if (cnorm*opnorm> tol/fac) {
 		        ndone++;
+		        napplied++;
 		        tensorT result = op->apply(source, *it, c, tol/fac/cnorm);
 			if (result.normf() > 0.3*tol/fac) {
+			  maxdistsq_kept = std::max<unsigned long>(maxdistsq_kept, dsq);
 			  if (coeffs.is_local(dest))
 			      coeffs.send(dest, &nodeT::accumulate2, result, coeffs, dest);
 			  else
   			      coeffs.task(dest, &nodeT::accumulate2, result, coeffs, dest);
                         }
+                        else {
+                          ndiscarded++;
+                        }
+                    }
+                    else {
+                        nscreened++;
+                        if (dsq > maxdistsq) break;
                     }
                 }
             }
+            op->apply_stats().add(n, nconsidered, nscreened, napplied, ndiscarded, maxdistsq_kept);
         }
 
 
@@ -4497,6 +4879,7 @@ namespace madness {
         void apply(opT& op, const FunctionImpl<R,NDIM>& f, bool fence) {
             PROFILE_MEMBER_FUNC(FunctionImpl);
             MADNESS_ASSERT(!op.modified());
+            if (op.adaptive_cutoff()) op.learn_cutoff();
             typename dcT::const_iterator end = f.coeffs.end();
             for (typename dcT::const_iterator it=f.coeffs.begin(); it!=end; ++it) {
                 // looping through all the coefficients in the source
@@ -5205,6 +5588,10 @@ namespace madness {
        }
 #endif
 
+        static double conj(double x) {
+            return x;
+        }
+
         static double conj(float x) {
             return x;
         }
@@ -5265,6 +5652,99 @@ namespace madness {
             return r;
         }
 
+        /// Adds the screened contributions of boxes in [lstart,lend) to a sparse matrix of inner products
+
+        /// The contribution of a box to pair (i,j) is bounded by the product
+        /// of the norms of the coefficients, so only functions that can
+        /// contribute more than \c thresh enter the matrix product, and only
+        /// pairs above \c thresh are accumulated.  Element (i,j) is stored
+        /// with key \c i*ncol+j .
+        template <typename R>
+        static void do_inner_local_sparse(const typename mapT::iterator lstart,
+                                          const typename mapT::iterator lend,
+                                          typename FunctionImpl<R,NDIM>::mapT* rmap_ptr,
+                                          const bool sym,
+                                          const double thresh,
+                                          const int64_t ncol,
+                                          ConcurrentHashMap< int64_t, TENSOR_RESULT_TYPE(T,R) >* result_ptr) {
+            typedef TENSOR_RESULT_TYPE(T,R) resultT;
+            for (typename mapT::iterator lit=lstart; lit!=lend; ++lit) {
+                typename FunctionImpl<R,NDIM>::mapT::iterator rit=rmap_ptr->find(lit->first);
+                if (rit == rmap_ptr->end()) continue;
+                const mapvecT& leftv = lit->second;
+                const typename FunctionImpl<R,NDIM>::mapvecT& rightv = rit->second;
+
+                std::vector<double> lnorm(leftv.size()), rnorm(rightv.size());
+                double lmax = 0.0, rmax = 0.0;
+                for (std::size_t iv=0; iv<leftv.size(); ++iv) {
+                    lnorm[iv] = leftv[iv].second->normf();
+                    lmax = std::max(lmax, lnorm[iv]);
+                }
+                for (std::size_t jv=0; jv<rightv.size(); ++jv) {
+                    rnorm[jv] = rightv[jv].second->normf();
+                    rmax = std::max(rmax, rnorm[jv]);
+                }
+                std::vector<std::size_t> lsel, rsel;
+                for (std::size_t iv=0; iv<leftv.size(); ++iv) if (lnorm[iv]*rmax > thresh) lsel.push_back(iv);
+                for (std::size_t jv=0; jv<rightv.size(); ++jv) if (rnorm[jv]*lmax > thresh) rsel.push_back(jv);
+                if (lsel.empty() || rsel.empty()) continue;
+
+                const long size = leftv[0].second->size();
+                Tensor<T> Left(lsel.size(), size);
+                Tensor<R> Right(rsel.size(), size);
+                Tensor<resultT> r(lsel.size(), rsel.size());
+                for (std::size_t ii=0; ii<lsel.size(); ++ii) Left(ii,_) = *(leftv[lsel[ii]].second);
+                for (std::size_t jj=0; jj<rsel.size(); ++jj) Right(jj,_) = *(rightv[rsel[jj]].second);
+                if (TensorTypeData<T>::iscomplex) Left = Left.conj();
+                mxmT(lsel.size(), rsel.size(), size, r.ptr(), Left.ptr(), Right.ptr());
+
+                for (std::size_t ii=0; ii<lsel.size(); ++ii) {
+                    const int64_t i = leftv[lsel[ii]].first;
+                    for (std::size_t jj=0; jj<rsel.size(); ++jj) {
+                        const int64_t j = rightv[rsel[jj]].first;
+                        if ((sym && i>j) || !(lnorm[lsel[ii]]*rnorm[rsel[jj]] > thresh)) continue;
+                        typename ConcurrentHashMap< int64_t, resultT >::accessor acc;
+                        result_ptr->insert(acc, i*ncol + j);
+                        acc->second += r(ii,jj);
+                    }
+                }
+            }
+        }
+
+        /// Local contributions to the matrix of inner products stored sparsely
+
+        /// Like inner_local(), but instead of a dense matrix only the pairs
+        /// of functions that overlap in some local box, with a contribution
+        /// above \c thresh , are added to \c result with key \c i*right.size()+j .
+        /// If \c sym only pairs \c i<=j are computed.  Local concurrency
+        /// only; no communication.
+        template <typename R>
+        static void
+        inner_local_sparse(const std::vector<const FunctionImpl<T,NDIM>*>& left,
+                           const std::vector<const FunctionImpl<R,NDIM>*>& right,
+                           bool sym, double thresh,
+                           ConcurrentHashMap< int64_t, TENSOR_RESULT_TYPE(T,R) >& result) {
+            if (left.empty() || right.empty()) return;
+            mapT lmap = make_key_vec_map(left);
+            typename FunctionImpl<R,NDIM>::mapT rmap;
+            typename FunctionImpl<R,NDIM>::mapT* rmap_ptr = (typename FunctionImpl<R,NDIM>::mapT*)(&lmap);
+            if ((std::vector<const FunctionImpl<R,NDIM>*>*)(&left) != &right) {
+                rmap = FunctionImpl<R,NDIM>::make_key_vec_map(right);
+                rmap_ptr = &rmap;
+            }
+
+            size_t chunk = (lmap.size()-1)/(3*4*5)+1;
+            typename mapT::iterator lstart=lmap.begin();
+            while (lstart != lmap.end()) {
+                typename mapT::iterator lend = lstart;
+                advance(lend,chunk);
+                left[0]->world.taskq.add(&FunctionImpl<T,NDIM>::do_inner_local_sparse<R>, lstart, lend,
+                                         rmap_ptr, sym, thresh, int64_t(right.size()), &result);
+                lstart = lend;
+            }
+            left[0]->world.taskq.fence();
+        }
+
         /// Return the inner product with an external function on a specified function node.
         /// @param[in] key Key of the function node to compute the inner product on. (the domain of integration)
         /// @param[in] c Tensor of coefficients for the function at the function node given by key
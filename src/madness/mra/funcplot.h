@@ -426,13 +426,15 @@ namespace madness {
         World& world = f.world();
         f.reconstruct();
         if (world.rank() == 0) {
+            std::vector<coordT> r(npt);
+            for (int i=0; i<npt; ++i) r[i] = lo + h*double(i);
+            Future< std::vector<T> > fr = f.eval(r);
             FILE* file = fopen(filename,"w");
 	    if(!file)
 	      MADNESS_EXCEPTION("plot_line: failed to open the plot file", 0);
             for (int i=0; i<npt; ++i) {
-                coordT r = lo + h*double(i);
                 fprintf(file, "%.14e ", i*sum);
-                plot_line_print_value(file, f.eval(r));
+                plot_line_print_value(file, fr.get()[i]);
                 fprintf(file,"\n");
             }
             fclose(file);
@@ -457,14 +459,17 @@ namespace madness {
         f.reconstruct();
         g.reconstruct();
         if (world.rank() == 0) {
+            std::vector<coordT> r(npt);
+            for (int i=0; i<npt; ++i) r[i] = lo + h*double(i);
+            Future< std::vector<T> > fr = f.eval(r);
+            Future< std::vector<U> > gr = g.eval(r);
             FILE* file = fopen(filename,"w");
 	    if(!file)
 	      MADNESS_EXCEPTION("plot_line: failed to open the plot file", 0);
             for (int i=0; i<npt; ++i) {
-                coordT r = lo + h*double(i);
                 fprintf(file, "%.14e ", i*sum);
-                plot_line_print_value(file, f.eval(r));
-                plot_line_print_value(file, g.eval(r));
+                plot_line_print_value(file, fr.get()[i]);
+                plot_line_print_value(file, gr.get()[i]);
                 fprintf(file,"\n");
             }
             fclose(file);
@@ -491,15 +496,19 @@ namespace madness {
         g.reconstruct();
         a.reconstruct();
         if (world.rank() == 0) {
+            std::vector<coordT> r(npt);
+            for (int i=0; i<npt; ++i) r[i] = lo + h*double(i);
+            Future< std::vector<T> > fr = f.eval(r);
+            Future< std::vector<U> > gr = g.eval(r);
+            Future< std::vector<V> > ar = a.eval(r);
             FILE* file = fopen(filename,"w");
 	    if(!file)
 	      MADNESS_EXCEPTION("plot_line: failed to open the plot file", 0);
             for (int i=0; i<npt; ++i) {
-                coordT r = lo + h*double(i);
                 fprintf(file, "%.14e ", i*sum);
-                plot_line_print_value(file, f.eval(r));
-                plot_line_print_value(file, g.eval(r));
-                plot_line_print_value(file, a.eval(r));
+                plot_line_print_value(file, fr.get()[i]);
+                plot_line_print_value(file, gr.get()[i]);
+                plot_line_print_value(file, ar.get()[i]);
                 fprintf(file,"\n");
             }
             fclose(file);
@@ -526,14 +535,19 @@ namespace madness {
         a.reconstruct();
         b.reconstruct();
         if (world.rank() == 0) {
+            std::vector<coordT> r(npt);
+            for (int i=0; i<npt; ++i) r[i] = lo + h*double(i);
+            Future< std::vector<T> > fr = f.eval(r);
+            Future< std::vector<U> > gr = g.eval(r);
+            Future< std::vector<V> > ar = a.eval(r);
+            Future< std::vector<W> > br = b.eval(r);
             FILE* file = fopen(filename,"w");
             for (int i=0; i<npt; ++i) {
-                coordT r = lo + h*double(i);
                 fprintf(file, "%.14e ", i*sum);
-                plot_line_print_value(file, f.eval(r));
-                plot_line_print_value(file, g.eval(r));
-                plot_line_print_value(file, a.eval(r));
-                plot_line_print_value(file, b.eval(r));
+                plot_line_print_value(file, fr.get()[i]);
+                plot_line_print_value(file, gr.get()[i]);
+                plot_line_print_value(file, ar.get()[i]);
+                plot_line_print_value(file, br.get()[i]);
                 fprintf(file,"\n");
             }
             fclose(file);
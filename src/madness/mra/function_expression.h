@@ -0,0 +1,319 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_MRA_FUNCTION_EXPRESSION_H__INCLUDED
+#define MADNESS_MRA_FUNCTION_EXPRESSION_H__INCLUDED
+
+/// \file function_expression.h
+/// \brief Lazy evaluation of arithmetic expressions of Functions
+/// \ingroup mra
+///
+/// An expression such as
+/// \code
+///   real_function_3d r = lazy(f)*a + lazy(g)*lazy(h)*b - lazy(V)*lazy(psi);
+/// \endcode
+/// is not evaluated term by term. Instead the operands are recorded and the
+/// expression is evaluated in a single traversal over the union of the input
+/// trees (FunctionImpl::multiopXX), where each leaf box is computed from the
+/// function values of all operands. Only the result is allocated; no
+/// intermediate functions and no refine_to_common_level are needed.
+///
+/// Products are formed in the values at the quadrature points of the finest
+/// box. If the expression contains a product, boxes where an operand with
+/// the autorefine flag set fails the squaring test are subdivided during the
+/// traversal, so that the product is not formed on boxes too coarse to
+/// represent it; the operands themselves are left unchanged.
+/// All operands must share the process map of the first one.
+
+#include <madness/mra/mra.h>
+
+namespace madness {
+
+    /// One instruction of the per-box stack machine evaluating a FunctionExpression
+    template <typename T>
+    struct FunctionExpressionInstruction {
+        enum opcode {LOAD, ADD, MUL, SCALE};
+
+        int code;       ///< what to do
+        long index;     ///< operand index for LOAD
+        T alpha;        ///< scale factor for SCALE
+
+        FunctionExpressionInstruction() : code(LOAD), index(0), alpha(0.0) {}
+        FunctionExpressionInstruction(int code, long index, T alpha)
+            : code(code), index(index), alpha(alpha) {}
+
+        template <typename Archive>
+        void serialize(Archive& ar) {
+            ar & code & index & alpha;
+        }
+    };
+
+    /// Evaluates the expression program on the values of the operands in one box
+    template <typename T, std::size_t NDIM>
+    struct FunctionExpressionValueOp {
+        typedef FunctionExpressionInstruction<T> instructionT;
+        std::vector<instructionT> program;
+
+        FunctionExpressionValueOp() {}
+        FunctionExpressionValueOp(const std::vector<instructionT>& program) : program(program) {}
+
+        Tensor<T> operator()(const Key<NDIM>& key, const std::vector< Tensor<T> >& values) const {
+            std::vector< Tensor<T> > stack;
+            stack.reserve(program.size());
+            for (const instructionT& ins : program) {
+                switch (ins.code) {
+                case instructionT::LOAD:
+                    stack.push_back(copy(values[ins.index]));
+                    break;
+                case instructionT::ADD: {
+                    Tensor<T> b = stack.back(); stack.pop_back();
+                    stack.back() += b;
+                    break;
+                }
+                case instructionT::MUL: {
+                    Tensor<T> b = stack.back(); stack.pop_back();
+                    stack.back().emul(b);
+                    break;
+                }
+                case instructionT::SCALE:
+                    stack.back().scale(ins.alpha);
+                    break;
+                default:
+                    MADNESS_EXCEPTION("FunctionExpression: invalid opcode", ins.code);
+                }
+            }
+            MADNESS_ASSERT(stack.size() == 1);
+            return stack.back();
+        }
+
+        template <typename Archive>
+        void serialize(Archive& ar) {
+            ar & program;
+        }
+    };
+
+    /// A lazily evaluated arithmetic expression of Functions
+
+    /// Build with lazy() and the operators +, - and * (with Functions,
+    /// expressions or scalars); evaluate with evaluate() or by assignment to
+    /// a Function. Operands that share the same FunctionImpl are stored once.
+    template <typename T, std::size_t NDIM>
+    class FunctionExpression {
+    public:
+        typedef Function<T,NDIM> functionT;
+        typedef FunctionImpl<T,NDIM> implT;
+        typedef FunctionExpressionInstruction<T> instructionT;
+
+    private:
+        std::vector<functionT> operands;
+        std::vector<instructionT> program;
+
+        /// append the operands and program of another expression
+        void append(const FunctionExpression& other) {
+            std::vector<long> map(other.operands.size());
+            for (std::size_t i=0; i<other.operands.size(); ++i) {
+                map[i] = operands.size();
+                for (std::size_t j=0; j<operands.size(); ++j) {
+                    if (operands[j].get_impl() == other.operands[i].get_impl()) {
+                        map[i] = j;
+                        break;
+                    }
+                }
+                if (map[i] == long(operands.size())) operands.push_back(other.operands[i]);
+            }
+            for (instructionT ins : other.program) {
+                if (ins.code == instructionT::LOAD) ins.index = map[ins.index];
+                program.push_back(ins);
+            }
+        }
+
+        /// true if the program multiplies two functions
+        bool has_product() const {
+            for (const instructionT& ins : program)
+                if (ins.code == instructionT::MUL) return true;
+            return false;
+        }
+
+    public:
+        FunctionExpression() {}
+
+        /// An expression consisting of the single function f
+        FunctionExpression(const functionT& f)
+            : operands(1,f), program(1,instructionT(instructionT::LOAD,0,T(0.0))) {
+            f.verify();
+        }
+
+        /// Number of distinct functions in the expression
+        std::size_t size() const {return operands.size();}
+
+        FunctionExpression& operator+=(const FunctionExpression& other) {
+            if (program.empty()) return *this = other;
+            append(other);
+            program.push_back(instructionT(instructionT::ADD,0,T(0.0)));
+            return *this;
+        }
+
+        FunctionExpression operator+(const FunctionExpression& other) const {
+            FunctionExpression result(*this);
+            return result += other;
+        }
+
+        FunctionExpression operator-(const FunctionExpression& other) const {
+            FunctionExpression result(*this);
+            result.append(other);
+            result.program.push_back(instructionT(instructionT::SCALE,0,T(-1.0)));
+            result.program.push_back(instructionT(instructionT::ADD,0,T(0.0)));
+            return result;
+        }
+
+        FunctionExpression operator*(const FunctionExpression& other) const {
+            FunctionExpression result(*this);
+            result.append(other);
+            result.program.push_back(instructionT(instructionT::MUL,0,T(0.0)));
+            return result;
+        }
+
+        FunctionExpression operator*(const T alpha) const {
+            FunctionExpression result(*this);
+            result.program.push_back(instructionT(instructionT::SCALE,0,alpha));
+            return result;
+        }
+
+        FunctionExpression operator-() const {
+            return (*this)*T(-1.0);
+        }
+
+        /// Evaluate the expression in a single traversal of the operand trees
+
+        /// Operands are reconstructed if necessary, and refined on the fly
+        /// where they autorefine and the expression contains a product.
+        functionT evaluate(bool fence=true) const {
+            PROFILE_MEMBER_FUNC(FunctionExpression);
+            MADNESS_ASSERT(operands.size() > 0);
+            World& world = operands[0].world();
+
+            std::vector<const implT*> v(operands.size());
+            for (std::size_t i=0; i<operands.size(); ++i) {
+                operands[i].verify();
+                MADNESS_ASSERT(operands[i].k() == operands[0].k());
+                // multiopXXa looks up all operands at the owner of the result box
+                MADNESS_ASSERT(operands[i].get_pmap() == operands[0].get_pmap());
+                operands[i].reconstruct(false);
+                v[i] = operands[i].get_impl().get();
+            }
+            world.gop.fence();
+
+            functionT result;
+            result.set_impl(operands[0], false);
+            result.get_impl()->multiopXX(v, FunctionExpressionValueOp<T,NDIM>(program), fence,
+                                         has_product());
+            return result;
+        }
+
+        /// Evaluate the expression with a fence
+        operator functionT() const {
+            return evaluate(true);
+        }
+    };
+
+    /// Wrap a function into an expression for lazy evaluation
+    template <typename T, std::size_t NDIM>
+    FunctionExpression<T,NDIM> lazy(const Function<T,NDIM>& f) {
+        return FunctionExpression<T,NDIM>(f);
+    }
+
+    /// Evaluate a lazy expression with optional fence
+    template <typename T, std::size_t NDIM>
+    Function<T,NDIM> evaluate(const FunctionExpression<T,NDIM>& e, bool fence=true) {
+        return e.evaluate(fence);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpression<T,NDIM> operator*(const T alpha, const FunctionExpression<T,NDIM>& e) {
+        return e*alpha;
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpression<T,NDIM> operator+(const FunctionExpression<T,NDIM>& e, const Function<T,NDIM>& f) {
+        return e + FunctionExpression<T,NDIM>(f);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpression<T,NDIM> operator+(const Function<T,NDIM>& f, const FunctionExpression<T,NDIM>& e) {
+        return FunctionExpression<T,NDIM>(f) + e;
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpression<T,NDIM> operator-(const FunctionExpression<T,NDIM>& e, const Function<T,NDIM>& f) {
+        return e - FunctionExpression<T,NDIM>(f);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpression<T,NDIM> operator-(const Function<T,NDIM>& f, const FunctionExpression<T,NDIM>& e) {
+        return FunctionExpression<T,NDIM>(f) - e;
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpression<T,NDIM> operator*(const FunctionExpression<T,NDIM>& e, const Function<T,NDIM>& f) {
+        return e * FunctionExpression<T,NDIM>(f);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpression<T,NDIM> operator*(const Function<T,NDIM>& f, const FunctionExpression<T,NDIM>& e) {
+        return FunctionExpression<T,NDIM>(f) * e;
+    }
+
+    /// Multiplies and sums two vectors of functions r = \sum_i alpha[i] * a[i] * b[i]
+
+    /// In contrast to dot() the products are never formed as functions: all
+    /// terms are accumulated box by box in a single traversal. Terms with a
+    /// vanishing weight are skipped.
+    template <typename T, typename Q, std::size_t NDIM>
+    Function<T,NDIM> fused_dot(World& world,
+                               const std::vector< Function<T,NDIM> >& a,
+                               const std::vector< Function<T,NDIM> >& b,
+                               const Tensor<Q>& alpha,
+                               bool fence=true) {
+        PROFILE_BLOCK(Vfused_dot);
+        MADNESS_ASSERT(a.size() == b.size());
+        MADNESS_ASSERT(alpha.size() == long(a.size()));
+
+        FunctionExpression<T,NDIM> e;
+        for (std::size_t i=0; i<a.size(); ++i) {
+            if (alpha(i) != Q(0.0)) e += lazy(a[i])*b[i]*T(alpha(i));
+        }
+        if (e.size() == 0) return FunctionFactory<T,NDIM>(world);
+        return e.evaluate(fence);
+    }
+
+}
+
+#endif // MADNESS_MRA_FUNCTION_EXPRESSION_H__INCLUDED
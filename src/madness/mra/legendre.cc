@@ -35,6 +35,7 @@ using std::endl;
 
 #include <cmath>
 #include <madness/mra/legendre.h>
+#include <madness/mra/data_table.h>
 #include <madness/tensor/tensor.h>
 
 /// \file legendre.cc
@@ -93,7 +94,7 @@ namespace madness {
     static bool data_is_read = false;
     static const int max_npt = 64;
 
-    static const char *filename = "gaussleg";   // Is overridden by
+    static const char *filename = 0;   // Set by load_quadrature to override the embedded table
     // These are the points and weights on [-1,1]
     static Tensor<double> points[max_npt+1];
     static Tensor<double> weights[max_npt+1];
@@ -101,51 +102,56 @@ namespace madness {
     /// read_data loads the precomputed Gauss-Legendre data
     static bool read_data() {
         if (data_is_read) return true;
-        FILE *f = fopen(filename,"r");
-        if (!f) {
-            cout << "legendre: read_data: could not find file " << filename << endl;
-            return false;
+        FILE *f = 0;
+        if (filename) {
+            f = fopen(filename,"r");
+            if (!f) {
+                cout << "legendre: read_data: could not find file " << filename << endl;
+                return false;
+            }
         }
+        DataTableReader reader(f, gaussleg_table, gaussleg_table_size);
         for (int npt=0; npt<=max_npt; ++npt) {
             points[npt] = Tensor<double>(npt);
             weights[npt] = Tensor<double>(npt);
 
-            int nnpt;
-            if (fscanf(f,"%d",&nnpt) != 1) {
+            long nnpt;
+            if (!reader.read(nnpt)) {
                 cout << "legendre: read_data: failed reading " << npt << endl;
-                fclose(f);
                 return false;
             }
             if (nnpt != npt) {
                 cout << "legendre: read_data: npt did not match " << npt << endl;
-                fclose(f);
                 return false;
             }
             for (int i=0; i<npt; ++i) {
-                int ii;
-                if (fscanf(f,"%d %lf %lf",&ii,&points[npt][i],&weights[npt][i]) != 3) {
+                long ii;
+                if (!(reader.read(ii) && reader.read(points[npt][i]) && reader.read(weights[npt][i]))) {
                     cout << "legendre: read_data: failed reading data " << npt << " " << i << endl;
-                    fclose(f);
                     return false;
                 }
             }
         }
-        fclose(f);
         data_is_read = true;
         return true;
     }
 
     /// Collective routine to pre-load and cache the quadrature points and weights
 
-    /// Only process rank 0 will access the file.
+    /// If dir is null the table compiled into the library is used by every
+    /// process.  Otherwise only process rank 0 will access the file in dir.
     void load_quadrature(World& world, const char* dir) {
         if (data_is_read) return;
+        if (!dir) {
+            if (!read_data()) throw "load_quadrature: failed reading quadrature coefficients";
+            return;
+        }
         if (world.rank() == 0) {
             char buf[32768];
             buf[0] = 0;
             strcat(buf,dir);
             strcat(buf,"/");
-            strcat(buf,filename);
+            strcat(buf,"gaussleg");
             filename = strdup(buf);
             if (!read_data()) throw "load_quadrature: failed reading quadrature coefficients";
         }
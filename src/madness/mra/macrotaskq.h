@@ -0,0 +1,299 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_MRA_MACROTASKQ_H__INCLUDED
+#define MADNESS_MRA_MACROTASKQ_H__INCLUDED
+
+/// \file macrotaskq.h
+/// \brief Coarse-grained parallelism: independent tasks executed in subworlds
+/// \ingroup mra
+///
+/// The universe is split into subworlds, each of which processes whole tasks
+/// (e.g. a row of the exchange matrix, a response state or a displaced
+/// geometry) with the usual fine-grained machinery restricted to its own
+/// processes, so that there is no RMI traffic across subworlds. Input and
+/// output data, including Functions, are exchanged through a Cloud.
+/// \code
+///   Cloud cloud(universe);
+///   for (int i=0; i<n; ++i) cloud.store(universe, f[i], i);   // inputs
+///
+///   MacroTaskQ taskq(universe, nsubworld);
+///   taskq.run_all(tasks, cloud);      // task i loads record i, stores record n+i
+///
+///   for (int i=0; i<n; ++i) r[i] = cloud.load<real_function_3d>(universe, n+i);
+/// \endcode
+
+#include <madness/mra/mra.h>
+#include <madness/world/vector_archive.h>
+
+namespace madness {
+
+    /// Storage for data exchanged between the universe and its subworlds
+
+    /// Records are identified by user-chosen numbers. Serializable objects are
+    /// stored by rank 0 of the storing world. Functions are stored collectively,
+    /// one buffer with all local nodes per storing process, and can be
+    /// loaded into any world, where they are distributed with that world's
+    /// default process map.
+    /// Storing is non-blocking; data stored in one world becomes visible in the
+    /// others after a universe fence (e.g. at the start and end of
+    /// MacroTaskQ::run_all).
+    class Cloud {
+        typedef WorldContainer<long, std::vector<unsigned char> > containerT;
+
+        World& universe;
+        containerT container;
+
+        /// key of the part of a Function stored by process p of its world
+        long function_key(const long record, const ProcessID p) const {
+            return -(record*universe.size() + p) - 1;
+        }
+
+        std::vector<unsigned char> get_buffer(const long key) const {
+            containerT::const_iterator it = container.find(key).get();
+            if (it == container.end()) MADNESS_EXCEPTION("Cloud: record not found", key);
+            return it->second;
+        }
+
+        template <typename T>
+        void load_record(World& world, const long record, T& target) const {
+            std::vector<unsigned char> buffer = get_buffer(record);
+            archive::VectorInputArchive ar(buffer);
+            ar & target;
+        }
+
+        /// Load a Function, each process keeps the nodes it owns in world
+
+        /// Every buffer of the storing processes is fetched once per loading
+        /// process, all of them requested before the first is read.
+        template <typename T, std::size_t NDIM>
+        void load_record(World& world, const long record, Function<T,NDIM>& target) const {
+            typedef typename FunctionImpl<T,NDIM>::dcT dcT;
+            int k, nproc;
+            double thresh;
+            std::vector<unsigned char> buffer0 = get_buffer(function_key(record,0));
+            {
+                archive::VectorInputArchive ar(buffer0);
+                ar & k & thresh & nproc;
+            }
+
+            target = FunctionFactory<T,NDIM>(world).k(k).thresh(thresh).empty();
+            dcT& coeffs = target.get_impl()->get_coeffs();
+
+            std::vector< Future<containerT::const_iterator> > parts;
+            for (ProcessID p=1; p<nproc; ++p) parts.push_back(container.find(function_key(record,p)));
+
+            for (ProcessID p=0; p<nproc; ++p) {
+                std::vector<unsigned char> buffer;
+                if (p == 0) {
+                    buffer.swap(buffer0);
+                } else {
+                    containerT::const_iterator it = parts[p-1].get();
+                    if (it == container.end()) MADNESS_EXCEPTION("Cloud: record not found", record);
+                    buffer = it->second;
+                }
+                archive::VectorInputArchive ar(buffer);
+                long nnode;
+                ar & k & thresh & nproc & nnode;
+                for (long i=0; i<nnode; ++i) {
+                    Key<NDIM> key;
+                    FunctionNode<T,NDIM> node;
+                    ar & key & node;
+                    if (coeffs.is_local(key)) coeffs.replace(key,node);
+                }
+            }
+            world.gop.fence();
+        }
+
+    public:
+        /// Construct the cloud, collective in the universe
+        Cloud(World& universe) : universe(universe), container(universe) {}
+
+        /// Store a serializable object, collective in world
+        template <typename T>
+        void store(World& world, const T& source, const long record) {
+            MADNESS_ASSERT(record >= 0);
+            if (world.rank() != 0) return;
+            std::vector<unsigned char> buffer;
+            archive::VectorOutputArchive ar(buffer);
+            ar & source;
+            container.replace(record, buffer);
+        }
+
+        /// Store a Function, collective in world, the world of the function
+
+        /// The function is reconstructed first. Each process stores its nodes
+        /// with their keys in a single buffer.
+        template <typename T, std::size_t NDIM>
+        void store(World& world, const Function<T,NDIM>& source, const long record) {
+            typedef typename FunctionImpl<T,NDIM>::dcT dcT;
+            MADNESS_ASSERT(record >= 0);
+            MADNESS_ASSERT(world.id() == source.world().id());
+            source.reconstruct();
+            const dcT& coeffs = source.get_impl()->get_coeffs();
+            const long nnode = coeffs.size();
+
+            std::vector<unsigned char> buffer;
+            archive::VectorOutputArchive ar(buffer);
+            ar & source.k() & source.thresh() & world.size() & nnode;
+            for (typename dcT::const_iterator it=coeffs.begin(); it!=coeffs.end(); ++it) {
+                ar & it->first & it->second;
+            }
+            container.replace(function_key(record,world.rank()), buffer);
+        }
+
+        /// Load an object or a Function, collective in world
+        template <typename T>
+        T load(World& world, const long record) const {
+            MADNESS_ASSERT(record >= 0);
+            T target;
+            load_record(world, record, target);
+            return target;
+        }
+
+        /// Remove all records, collective in the universe
+        void clear() {
+            universe.gop.fence();
+            container.clear();
+            universe.gop.fence();
+        }
+    };
+
+
+    /// Base class for tasks executed by a MacroTaskQ
+    class MacroTaskBase {
+    public:
+        virtual ~MacroTaskBase() {}
+
+        /// Execute the task, collective in subworld
+
+        /// Inputs are loaded from and results stored into the cloud.
+        virtual void run(World& subworld, Cloud& cloud) = 0;
+    };
+
+
+    /// Splits the universe into subworlds and farms out macro tasks to them
+
+    /// Process p of the universe belongs to subworld p%nsubworld. Tasks are
+    /// handed out dynamically by universe rank 0, so that subworlds finishing
+    /// early pick up the remaining work.
+    class MacroTaskQ : public WorldObject<MacroTaskQ> {
+        World& universe;
+        std::shared_ptr<World> subworld_ptr;
+        int nsubworld;
+        AtomicInt counter;      ///< the next task to be handed out, only used on rank 0
+
+        /// Return the index of the next task, invoked on universe rank 0
+        long next_task() {
+            return counter++;
+        }
+
+        /// Sets the default process maps of all dimensions for a world, restores them upon destruction
+        struct pmap_guard {
+            std::shared_ptr< WorldDCPmapInterface< Key<1> > > pmap1;
+            std::shared_ptr< WorldDCPmapInterface< Key<2> > > pmap2;
+            std::shared_ptr< WorldDCPmapInterface< Key<3> > > pmap3;
+            std::shared_ptr< WorldDCPmapInterface< Key<4> > > pmap4;
+            std::shared_ptr< WorldDCPmapInterface< Key<5> > > pmap5;
+            std::shared_ptr< WorldDCPmapInterface< Key<6> > > pmap6;
+
+            template <std::size_t NDIM>
+            static void set_pmap(World& world) {
+                FunctionDefaults<NDIM>::set_pmap(std::shared_ptr< WorldDCPmapInterface< Key<NDIM> > >
+                                                 (new LevelPmap< Key<NDIM> >(world)));
+            }
+
+            pmap_guard(World& world)
+                : pmap1(FunctionDefaults<1>::get_pmap()), pmap2(FunctionDefaults<2>::get_pmap())
+                , pmap3(FunctionDefaults<3>::get_pmap()), pmap4(FunctionDefaults<4>::get_pmap())
+                , pmap5(FunctionDefaults<5>::get_pmap()), pmap6(FunctionDefaults<6>::get_pmap()) {
+                set_pmap<1>(world);
+                set_pmap<2>(world);
+                set_pmap<3>(world);
+                set_pmap<4>(world);
+                set_pmap<5>(world);
+                set_pmap<6>(world);
+            }
+
+            ~pmap_guard() {
+                FunctionDefaults<1>::set_pmap(pmap1);
+                FunctionDefaults<2>::set_pmap(pmap2);
+                FunctionDefaults<3>::set_pmap(pmap3);
+                FunctionDefaults<4>::set_pmap(pmap4);
+                FunctionDefaults<5>::set_pmap(pmap5);
+                FunctionDefaults<6>::set_pmap(pmap6);
+            }
+        };
+
+    public:
+        /// Split the universe into nsubworld subworlds, collective in the universe
+        MacroTaskQ(World& universe, const int nsubworld)
+            : WorldObject<MacroTaskQ>(universe), universe(universe), nsubworld(nsubworld) {
+            MADNESS_ASSERT(nsubworld > 0 and nsubworld <= universe.size());
+            counter = 0;
+            SafeMPI::Intracomm comm = universe.mpi.comm().Split(universe.rank()%nsubworld,
+                                                                 universe.rank()/nsubworld);
+            subworld_ptr.reset(new World(comm));
+            process_pending();
+        }
+
+        /// The subworld this process belongs to
+        World& get_subworld() {return *subworld_ptr;}
+
+        int get_nsubworld() const {return nsubworld;}
+
+        /// Execute all tasks, collective in the universe
+
+        /// All processes must pass the same list of tasks. While tasks run,
+        /// Functions created in the subworlds use subworld process maps.
+        void run_all(const std::vector< std::shared_ptr<MacroTaskBase> >& tasks, Cloud& cloud) {
+            World& subworld = get_subworld();
+            universe.gop.fence();
+            {
+                pmap_guard guard(subworld);
+                while (true) {
+                    long itask = 0;
+                    if (subworld.rank() == 0) itask = send(0, &MacroTaskQ::next_task).get();
+                    subworld.gop.broadcast(itask, 0);
+                    if (itask >= long(tasks.size())) break;
+                    tasks[itask]->run(subworld, cloud);
+                    subworld.gop.fence();
+                }
+            }
+            universe.gop.fence();
+            counter = 0;
+            universe.gop.fence();
+        }
+    };
+
+}
+
+#endif // MADNESS_MRA_MACROTASKQ_H__INCLUDED
@@ -204,6 +204,40 @@ class Function : public archive::ParallelSerializableObject {
     return result;
   }
 
+  /// Evaluates the function at many points in user coordinates.  Possible
+  /// non-blocking comm.
+
+  /// The points are routed down the tree in batches, one message per box
+  /// and owner, and all points within a leaf box are evaluated together.
+  /// Only the invoking process will receive the result via the future;
+  /// the values are in the order of the input points.
+  ///
+  /// Throws if function is not initialized.
+  Future<std::vector<T> > eval(const std::vector<coordT>& xuser) const {
+    PROFILE_MEMBER_FUNC(Function);
+    const double eps = 1e-15;
+    verify();
+    MADNESS_ASSERT(!is_compressed());
+    std::vector<coordT> xsim(xuser.size());
+    for (std::size_t i = 0; i < xuser.size(); ++i) {
+      user_to_sim(xuser[i], xsim[i]);
+      for (std::size_t d = 0; d < NDIM; ++d) {
+        if (xsim[i][d] < -eps) {
+          MADNESS_EXCEPTION("eval: coordinate lower-bound error in dimension", d);
+        } else if (xsim[i][d] < eps) {
+          xsim[i][d] = eps;
+        }
+
+        if (xsim[i][d] > 1.0 + eps) {
+          MADNESS_EXCEPTION("eval: coordinate upper-bound error in dimension", d);
+        } else if (xsim[i][d] > 1.0 - eps) {
+          xsim[i][d] = 1.0 - eps;
+        }
+      }
+    }
+    return impl->eval_batch(impl->key0(), xsim);
+  }
+
   /// Evaluate function only if point is local returning (true,value); otherwise
   /// return (false,0.0)
 
@@ -2516,6 +2550,7 @@ void load(Function<T, NDIM>& f, const std::string name) {
 #include <madness/mra/functypedefs.h>
 #include <madness/mra/operator.h>
 #include <madness/mra/vmra.h>
+#include <madness/mra/function_expression.h>
 // #include <madness/mra/mraimpl.h> !!!!!!!!!!!!!
 // NOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOO  !!!!!!!!!!!!!!!!!!
 
@@ -47,6 +47,14 @@ namespace madness {
     ConcurrentHashMap< hashT, std::shared_ptr< GaussianConvolution1D<double_complex> > >
     GaussianConvolution1DCache<double_complex>::map = ConcurrentHashMap< hashT, std::shared_ptr< GaussianConvolution1D<double_complex> > >();
 
+    template <>
+    GaussianConvolution1DCache<double>::imagesT
+    GaussianConvolution1DCache<double>::images = GaussianConvolution1DCache<double>::imagesT();
+
+    template <>
+    GaussianConvolution1DCache<double_complex>::imagesT
+    GaussianConvolution1DCache<double_complex>::images = GaussianConvolution1DCache<double_complex>::imagesT();
+
 #ifdef FUNCTION_INSTANTIATE_1
 
     template void fcube<double,1>(const Key<1>&, const FunctionFunctorInterface<double,1>&, const Tensor<double>&, Tensor<double>&);
@@ -38,6 +38,8 @@
 
 //#define WORLD_INSTANTIATE_STATIC_TEMPLATES
 #include <memory>
+#include <map>
+#include <set>
 #include <math.h>
 #include <cmath>
 #include <madness/world/world_object.h>
@@ -1044,6 +1046,50 @@ namespace madness {
     }
 
 
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::do_diff_multi(const std::vector<const DerivativeBase<T,NDIM>*>& D,
+                                             const implT* f,
+                                             const std::vector<implT*>& df,
+                                             const keyT& key,
+                                             const std::vector< Future< std::pair<keyT,coeffT> > >& left,
+                                             const std::pair<keyT,coeffT>& center,
+                                             const std::vector< Future< std::pair<keyT,coeffT> > >& right) {
+        for (std::size_t i=0; i<D.size(); ++i) {
+            D[i]->do_diff1(f, df[i], key, left[i].get(), center, right[i].get());
+        }
+    }
+
+
+    // Called by the first result function to apply several derivatives to f
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::diff_multi(const std::vector<const DerivativeBase<T,NDIM>*>& D,
+                                          const implT* f,
+                                          const std::vector<implT*>& df,
+                                          bool fence) {
+        typedef std::pair<keyT,coeffT> argT;
+        MADNESS_ASSERT(D.size()==df.size() && D.size()>0 && df[0]==this);
+        typename dcT::const_iterator end = f->coeffs.end();
+        for (typename dcT::const_iterator it=f->coeffs.begin(); it!=end; ++it) {
+            const keyT& key = it->first;
+            const nodeT& node = it->second;
+            if (node.has_coeff()) {
+                std::vector< Future<argT> > left(D.size()), right(D.size());
+                for (std::size_t i=0; i<D.size(); ++i) {
+                    left[i]  = D[i]->find_neighbor(f, key,-1);
+                    right[i] = D[i]->find_neighbor(f, key, 1);
+                }
+                argT center(key,node.coeff());
+                world.taskq.add(*this, &implT::do_diff_multi, D, f, df, key, left, center, right, TaskAttributes::hipri());
+            }
+            else {
+                for (std::size_t i=0; i<df.size(); ++i)
+                    df[i]->coeffs.replace(key,nodeT(coeffT(),true)); // Empty internal node
+            }
+        }
+        if (fence) world.gop.fence();
+    }
+
+
     /// return the a std::pair<key, node>, which MUST exist
     template <typename T, std::size_t NDIM>
     std::pair<Key<NDIM>,ShallowNode<T,NDIM> > FunctionImpl<T,NDIM>::find_datum(keyT key) const {
@@ -1574,6 +1620,30 @@ namespace madness {
         }
     }
 
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::local_box_norms(const int n, Tensor<double>& norms) const {
+        MADNESS_ASSERT(norms.size() == (1l<<(n*NDIM)));
+        typename dcT::const_iterator end = coeffs.end();
+        for (typename dcT::const_iterator it=coeffs.begin(); it!=end; ++it) {
+            const keyT& key = it->first;
+            const nodeT& node = it->second;
+            const int m = key.level();
+            if (m > n) continue;
+            if (m < n and node.has_children()) continue;
+
+            // leaf at or interior node on level n: spread over its descendants on level n
+            const double norm = std::max(0.0, node.get_norm_tree());
+            const Vector<Translation,NDIM>& l = key.translation();
+            for (IndexIterator ii(NDIM, 1l<<(n-m)); ii; ++ii) {
+                long index = 0;
+                for (std::size_t d=0; d<NDIM; ++d) {
+                    index = (index<<n) + (l[d]<<(n-m)) + ii[d];
+                }
+                norms(index) = norm;
+            }
+        }
+    }
+
     /// truncate using a tree in reconstructed form
 
     /// must be invoked where key is local
@@ -2400,11 +2470,7 @@ namespace madness {
             //////////////////////////if (newspecialpts.size() == 0)
             {
                 // Make in r child scaling function coeffs at level n+1
-                r = tensorT(cdata.v2k);
-                for (KeyChildIterator<NDIM> it(key); it; ++it) {
-                    const keyT& child = it.key();
-                    r(child_patch(child)) = project(child);
-                }
+                r = project_children(key);
                 // Filter then test difference coeffs at level n
                 tensorT d = filter(r);
                 if (truncate_on_project) s0 = copy(d(cdata.s0));
@@ -2449,6 +2515,110 @@ namespace madness {
         }
     }
 
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::project_refine_multi_op(const keyT& key, const std::vector<implT*>& v,
+                                                       const std::vector<int>& active,
+                                                       const std::vector<std::vector<coordT> >& specialpts) {
+        //PROFILE_MEMBER_FUNC(FunctionImpl);
+        const Level n = key.level();
+        const Vector<Translation,NDIM>& l = key.translation();
+        const Tensor<double>& cell_width = FunctionDefaults<NDIM>::get_cell_width();
+        const Tensor<double>& cell = FunctionDefaults<NDIM>::get_cell();
+        const double h = std::pow(0.5,double(n));
+        coordT lo, hi; // corners of the box in user coordinates
+        for (std::size_t d=0; d<NDIM; ++d) {
+            lo[d] = cell(d,0) + h*cell_width[d]*l[d];
+            hi[d] = lo[d] + h*cell_width[d];
+        }
+        const std::vector<bool> bperiodic = FunctionDefaults<NDIM>::get_bc().is_periodic();
+
+        std::vector<int> refine;
+        std::vector<std::vector<coordT> > newspecialpts;
+        for (std::size_t ii=0; ii<active.size(); ++ii) {
+            const int i = active[ii];
+            implT& f = *v[i];
+            if (n < f.initial_level) {
+                f.coeffs.replace(key,nodeT(coeffT(),true));
+                refine.push_back(i);
+                newspecialpts.push_back(specialpts[ii]);
+            }
+            else if (f.functor->screened(lo, hi)) {
+                f.coeffs.replace(key,nodeT(coeffT(cdata.vk,f.targs),false));
+            }
+            else if (n >= f.max_refine_level) {
+                f.coeffs.replace(key,nodeT(coeffT(f.project(key),f.targs),false));
+            }
+            else {
+                // Restrict the special points to this box, always refine next to them
+                std::vector<coordT> pts;
+                if (n < f.functor->special_level()) {
+                    for (const coordT& pt : specialpts[ii]) {
+                        coordT simpt;
+                        user_to_sim(pt, simpt);
+                        if (simpt2key(simpt, n).is_neighbor_of(key,bperiodic)) pts.push_back(pt);
+                    }
+                }
+                const bool special = (pts.size() > 0);
+
+                // Otherwise refine if the difference norm is big, as in project_refine_op
+                tensorT r = f.project_children(key);
+                tensorT d = filter(r);
+                tensorT s0;
+                if (f.truncate_on_project) s0 = copy(d(cdata.s0));
+                d(cdata.s0) = T(0);
+                const double dnorm = d.normf();
+
+                if (special || dnorm >= f.truncate_tol(f.thresh,key)) {
+                    f.coeffs.replace(key,nodeT(coeffT(),true));
+                    refine.push_back(i);
+                    newspecialpts.push_back(pts);
+                }
+                else if (f.truncate_on_project) {
+                    coeffT s(s0,f.thresh,FunctionDefaults<NDIM>::get_tensor_type());
+                    f.coeffs.replace(key,nodeT(s,false));
+                }
+                else {
+                    f.coeffs.replace(key,nodeT(coeffT(),true)); // Insert empty node for parent
+                    for (KeyChildIterator<NDIM> it(key); it; ++it) {
+                        const keyT& child = it.key();
+                        coeffT s(r(child_patch(child)),f.thresh,FunctionDefaults<NDIM>::get_tensor_type());
+                        f.coeffs.replace(child,nodeT(s,false));
+                    }
+                }
+            }
+        }
+
+        if (refine.empty()) return;
+        for (KeyChildIterator<NDIM> it(key); it; ++it) {
+            const keyT& child = it.key();
+            ProcessID p;
+            if (FunctionDefaults<NDIM>::get_project_randomize()) {
+                p = world.random_proc();
+            }
+            else {
+                p = coeffs.owner(child);
+            }
+            woT::task(p, &implT::project_refine_multi_op, child, v, refine, newspecialpts);
+        }
+    }
+
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::project_multi(const std::vector<implT*>& v, bool fence) {
+        MADNESS_ASSERT(v.size() > 0 and v[0] == this);
+        std::vector<int> active(v.size());
+        std::vector<std::vector<coordT> > specialpts(v.size());
+        for (std::size_t i=0; i<v.size(); ++i) {
+            MADNESS_ASSERT(v[i]->functor and v[i]->k == k);
+            MADNESS_ASSERT(v[i]->coeffs.get_pmap() == coeffs.get_pmap());
+            active[i] = i;
+            specialpts[i] = v[i]->functor->special_points();
+        }
+        if (world.rank() == coeffs.owner(cdata.key0))
+            project_refine_multi_op(cdata.key0, v, active, specialpts);
+        if (fence)
+            world.gop.fence();
+    }
+
     template <typename T, std::size_t NDIM>
     void FunctionImpl<T,NDIM>::add_scalar_inplace(T t, bool fence) {
         std::vector<long> v0(NDIM,0L);
@@ -2669,6 +2839,73 @@ namespace madness {
         return fast_transform(work,cdata.quad_phiw,fval,workq);
     }
 
+    template <typename T, std::size_t NDIM>
+    Tensor<T> FunctionImpl<T,NDIM>::project_children(const keyT& key) const {
+        //PROFILE_MEMBER_FUNC(FunctionImpl);
+        tensorT r(cdata.v2k);
+        if (functor->provides_coeff() or (not functor->supports_vectorized())) {
+            for (KeyChildIterator<NDIM> it(key); it; ++it) {
+                const keyT& child = it.key();
+                r(child_patch(child)) = project(child);
+            }
+            return r;
+        }
+
+        MADNESS_ASSERT(cdata.npt == cdata.k); // only necessary due to use of fast transform
+        const int npt = cdata.npt;
+        long nptbox = 1;
+        for (std::size_t d=0; d<NDIM; ++d) nptbox *= npt;
+        const Tensor<double>& qx = cdata.quad_x;
+        const Tensor<double>& cell_width = FunctionDefaults<NDIM>::get_cell_width();
+        const Tensor<double>& cell = FunctionDefaults<NDIM>::get_cell();
+        const double h = std::pow(0.5,double(key.level()+1));
+
+        // collect the quadrature points of all unscreened children in SoA layout
+        std::vector<keyT> children;
+        Vector<std::vector<double>,NDIM> x;
+        for (std::size_t d=0; d<NDIM; ++d) x[d].reserve(nptbox<<NDIM);
+        for (KeyChildIterator<NDIM> it(key); it; ++it) {
+            const keyT& child = it.key();
+            const Vector<Translation,NDIM>& l = child.translation();
+            Vector<std::vector<double>,NDIM> c;
+            coordT c1, c2;
+            for (std::size_t d=0; d<NDIM; ++d) {
+                c[d].resize(npt);
+                for (int i=0; i<npt; ++i) c[d][i] = cell(d,0) + h*cell_width[d]*(l[d] + qx(i));
+                c1[d] = c[d][0];
+                c2[d] = c[d][npt-1];
+            }
+            if (functor->screened(c1, c2)) continue;   // the patch in r remains zero
+
+            children.push_back(child);
+            for (long idx=0; idx<nptbox; ++idx) {
+                long rem = idx;
+                for (long d=NDIM-1; d>=0; --d) {
+                    x[d].push_back(c[d][rem%npt]);
+                    rem /= npt;
+                }
+            }
+        }
+        if (children.empty()) return r;
+
+        const long ntotal = nptbox*children.size();
+        std::vector<T> fvals(ntotal);
+        Vector<double*,NDIM> xvals;
+        for (std::size_t d=0; d<NDIM; ++d) xvals[d] = &(x[d][0]);
+        (*functor)(xvals, &fvals[0], ntotal);
+
+        const double scale = sqrt(FunctionDefaults<NDIM>::get_cell_volume()*pow(0.5,double(NDIM*(key.level()+1))));
+        tensorT work(cdata.vk,false);
+        tensorT workq(cdata.vq,false);
+        for (std::size_t i=0; i<children.size(); ++i) {
+            tensorT fval(cdata.vq,false);
+            std::copy(&fvals[i*nptbox], &fvals[i*nptbox]+nptbox, work.ptr());
+            work.scale(scale);
+            r(child_patch(children[i])) = fast_transform(work,cdata.quad_phiw,fval,workq);
+        }
+        return r;
+    }
+
     template <typename T, std::size_t NDIM>
     Future<double> FunctionImpl<T,NDIM>::get_norm_tree_recursive(const keyT& key) const {
         if (coeffs.probe(key)) {
@@ -2730,6 +2967,80 @@ namespace madness {
     }
 
 
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::make_halo(const BoundaryConditions<NDIM>& bc, bool fence) {
+        typedef std::pair<keyT,coeffT> argT;
+        halo.reset(new haloT);
+
+        // collect the distinct neighbors of all local leaves by owner
+        std::map< ProcessID, std::set<keyT> > request;
+        typename dcT::const_iterator end = coeffs.end();
+        for (typename dcT::const_iterator it=coeffs.begin(); it!=end; ++it) {
+            const keyT& key = it->first;
+            if (!it->second.has_coeff()) continue;
+            const Translation two2n = Translation(1) << key.level();
+            for (std::size_t d=0; d<NDIM; ++d) {
+                for (int step=-1; step<=1; step+=2) {
+                    Vector<Translation,NDIM> l = key.translation();
+                    l[d] += step;
+                    if (l[d] < 0 || l[d] >= two2n) {
+                        if (bc(d, (l[d] < 0) ? 0 : 1) != BC_PERIODIC) continue;
+                        l[d] = (l[d] + two2n) % two2n;
+                    }
+                    keyT neigh(key.level(), l);
+                    request[coeffs.owner(neigh)].insert(neigh);
+                }
+            }
+        }
+
+        for (typename std::map< ProcessID, std::set<keyT> >::const_iterator it=request.begin(); it!=request.end(); ++it) {
+            std::vector<keyT> keys(it->second.begin(), it->second.end());
+            Future< std::vector<argT> > data = woT::task(it->first, &implT::get_halo, keys, TaskAttributes::hipri());
+            woT::task(world.rank(), &implT::put_halo, keys, data);
+        }
+        if (fence) world.gop.fence();
+    }
+
+
+    template <typename T, std::size_t NDIM>
+    bool FunctionImpl<T,NDIM>::find_halo(const keyT& key, std::pair<keyT,coeffT>& datum) const {
+        if (!halo) return false;
+        typename haloT::const_iterator it = halo->find(key);
+        if (it == halo->end()) return false;
+        datum = it->second;
+        return true;
+    }
+
+
+    template <typename T, std::size_t NDIM>
+    Future< std::vector< std::pair<Key<NDIM>,GenTensor<T> > > >
+    FunctionImpl<T,NDIM>::get_halo(const std::vector<keyT>& keys) {
+        typedef std::pair<keyT,coeffT> argT;
+        std::vector< Future<argT> > v(keys.size());
+        for (std::size_t i=0; i<keys.size(); ++i) sock_it_to_me(keys[i], v[i].remote_ref(world));
+        return woT::task(world.rank(), &implT::get_halo_gather, v);
+    }
+
+
+    template <typename T, std::size_t NDIM>
+    std::vector< std::pair<Key<NDIM>,GenTensor<T> > >
+    FunctionImpl<T,NDIM>::get_halo_gather(const std::vector< Future< std::pair<keyT,coeffT> > >& v) const {
+        std::vector< std::pair<keyT,coeffT> > result(v.size());
+        for (std::size_t i=0; i<v.size(); ++i) result[i] = v[i].get();
+        return result;
+    }
+
+
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::put_halo(const std::vector<keyT>& keys,
+                                        const std::vector< std::pair<keyT,coeffT> >& data) {
+        MADNESS_ASSERT(halo && keys.size() == data.size());
+        for (std::size_t i=0; i<keys.size(); ++i) {
+            halo->insert(typename haloT::datumT(keys[i], data[i]));
+        }
+    }
+
+
     template <typename T, std::size_t NDIM>
     void FunctionImpl<T,NDIM>::eval(const Vector<double,NDIM>& xin,
                                     const keyT& keyin,
@@ -2773,6 +3084,111 @@ namespace madness {
     }
 
 
+    template <typename T, std::size_t NDIM>
+    Future< std::vector<T> > FunctionImpl<T,NDIM>::eval_batch(const keyT& key, const std::vector<coordT>& x) {
+        PROFILE_MEMBER_FUNC(FunctionImpl);
+        const ProcessID owner = coeffs.owner(key);
+        if (owner != world.rank()) {
+            return woT::task(owner, &implT::eval_batch, key, x, TaskAttributes::hipri());
+        }
+        if (x.empty()) return Future< std::vector<T> >(std::vector<T>());
+
+        const nodeT& node = coeffs.find(key).get()->second;
+        if (node.has_coeff()) {
+            return Future< std::vector<T> >(eval_points(key, x, node.coeff().full_tensor_copy()));
+        }
+
+        // sort the points into the children; child index bits run from dimension 0 (highest) to NDIM-1
+        const int nchild = 1<<NDIM;
+        const Vector<Translation,NDIM>& l = key.translation();
+        const double twon1 = std::pow(2.0, double(key.level()+1));
+        std::vector< std::vector<coordT> > xchild(nchild);
+        std::vector<int> which(x.size());
+        for (std::size_t i=0; i<x.size(); ++i) {
+            int ichild = 0;
+            for (std::size_t d=0; d<NDIM; ++d) {
+                Translation li = Translation(x[i][d]*twon1);
+                li = std::max(2*l[d], std::min(2*l[d]+1, li));
+                ichild = 2*ichild + int(li - 2*l[d]);
+            }
+            which[i] = ichild;
+            xchild[ichild].push_back(x[i]);
+        }
+
+        std::vector< Future< std::vector<T> > > v = future_vector_factory< std::vector<T> >(nchild);
+        for (int ichild=0; ichild<nchild; ++ichild) {
+            if (xchild[ichild].empty()) {
+                v[ichild] = Future< std::vector<T> >(std::vector<T>());
+                continue;
+            }
+            Vector<Translation,NDIM> lchild;
+            for (std::size_t d=0; d<NDIM; ++d) lchild[d] = 2*l[d] + ((ichild>>(NDIM-1-d)) & 1);
+            v[ichild] = eval_batch(keyT(key.level()+1,lchild), xchild[ichild]);
+        }
+        return woT::task(world.rank(), &implT::eval_batch_gather, which, v);
+    }
+
+
+    template <typename T, std::size_t NDIM>
+    std::vector<T> FunctionImpl<T,NDIM>::eval_points(const keyT& key, const std::vector<coordT>& x,
+                                                     const tensorT& c) const {
+        PROFILE_MEMBER_FUNC(FunctionImpl);
+        const int k = cdata.k;
+        const long npt = x.size();
+        const Level n = key.level();
+        const Vector<Translation,NDIM>& l = key.translation();
+        const double twon = std::pow(2.0, double(n));
+
+        // values of the scaling functions at the local coordinates of all points
+        std::vector< Tensor<double> > px(NDIM);
+        for (std::size_t d=0; d<NDIM; ++d) {
+            px[d] = Tensor<double>(npt,long(k));
+            for (long i=0; i<npt; ++i) {
+                double xi = x[i][d]*twon - l[d];
+                xi = std::max(0.0, std::min(1.0, xi));
+                legendre_scaling_functions(xi, k, px[d].ptr()+i*k);
+            }
+        }
+
+        // contract the first dimension for all points at once, the others point by point
+        const tensorT t = inner(px[0], c, 1, 0);
+        const long kr = t.size()/npt;
+        const T* tp = t.ptr();
+        std::vector<T> work(kr);
+        std::vector<T> result(npt);
+        const double scale = std::pow(2.0,0.5*NDIM*n)/std::sqrt(FunctionDefaults<NDIM>::get_cell_volume());
+        for (long i=0; i<npt; ++i) {
+            const T* src = tp + i*kr;
+            long m = kr;
+            for (std::size_t d=1; d<NDIM; ++d) {
+                const double* p = px[d].ptr() + i*k;
+                m /= k;
+                for (long j=0; j<m; ++j) {
+                    T sum = T(0.0);
+                    for (int q=0; q<k; ++q) sum += p[q]*src[q*m+j];
+                    work[j] = sum;
+                }
+                src = &work[0];
+            }
+            result[i] = src[0]*scale;
+        }
+        return result;
+    }
+
+
+    template <typename T, std::size_t NDIM>
+    std::vector<T> FunctionImpl<T,NDIM>::eval_batch_gather(const std::vector<int>& which,
+                                                           const std::vector< Future< std::vector<T> > >& v) const {
+        std::vector<T> result(which.size());
+        std::vector<std::size_t> next(v.size(),0);
+        for (std::size_t i=0; i<which.size(); ++i) {
+            const int ichild = which[i];
+            result[i] = v[ichild].get()[next[ichild]++];
+        }
+        return result;
+    }
+
+
     template <typename T, std::size_t NDIM>
     std::pair<bool,T>
     FunctionImpl<T,NDIM>::eval_local_only(const Vector<double,NDIM>& xin, Level maxlevel) {
@@ -3324,6 +3740,7 @@ namespace madness {
         truncate_on_project = true;
         apply_randomize = false;
         project_randomize = false;
+        lazy_accumulation = false;
         bc = BoundaryConditions<NDIM>(BC_FREE);
         tt = TT_FULL;
         cell = Tensor<double>(NDIM,2);
@@ -3350,6 +3767,7 @@ namespace madness {
     		std::cout << "             truncate_on_project" <<  ": " << truncate_on_project << std::endl;
     		std::cout << "                 apply_randomize" <<  ": " << apply_randomize << std::endl;
     		std::cout << "               project_randomize" <<  ": " << project_randomize << std::endl;
+    		std::cout << "               lazy_accumulation" <<  ": " << lazy_accumulation << std::endl;
     		std::cout << "                              bc" <<  ": " << bc << std::endl;
     		std::cout << "                              tt" <<  ": " << tt << std::endl;
     		std::cout << "                            cell" <<  ": " << cell << std::endl;
@@ -3370,6 +3788,7 @@ namespace madness {
     template <std::size_t NDIM> bool FunctionDefaults<NDIM>::truncate_on_project;
     template <std::size_t NDIM> bool FunctionDefaults<NDIM>::apply_randomize;
     template <std::size_t NDIM> bool FunctionDefaults<NDIM>::project_randomize;
+    template <std::size_t NDIM> bool FunctionDefaults<NDIM>::lazy_accumulation;
     template <std::size_t NDIM> BoundaryConditions<NDIM> FunctionDefaults<NDIM>::bc;
     template <std::size_t NDIM> TensorType FunctionDefaults<NDIM>::tt;
     template <std::size_t NDIM> Tensor<double> FunctionDefaults<NDIM>::cell;
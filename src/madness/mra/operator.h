@@ -48,6 +48,8 @@
 #include <madness/tensor/aligned.h>
 #include <madness/tensor/tensor_lapack.h>
 
+#include <array>
+#include <atomic>
 #include <type_traits>
 
 namespace madness {
@@ -76,6 +78,111 @@ struct SeparatedConvolutionData {
   }
 };
 
+/// Array of per-level atomic values; copies take a snapshot of the values
+template <typename T, std::size_t N>
+class AtomicLevelArray {
+  std::array<std::atomic<T>, N> v_;
+
+ public:
+  AtomicLevelArray() {
+    for (auto& a : v_) a = T();
+  }
+  AtomicLevelArray(const AtomicLevelArray& other) { *this = other; }
+  AtomicLevelArray& operator=(const AtomicLevelArray& other) {
+    for (std::size_t i = 0; i < N; ++i) v_[i] = other.v_[i].load();
+    return *this;
+  }
+  std::atomic<T>& operator[](std::size_t i) { return v_[i]; }
+  const std::atomic<T>& operator[](std::size_t i) const { return v_[i]; }
+};
+
+/// Counters of the displacement loop in FunctionImpl::do_apply, per level
+
+/// They show how tight the screening is: the number of source boxes, the
+/// displacements considered, those screened out by opnorm*cnorm, those
+/// applied, and those applied but discarded because the result was
+/// negligible.  The largest squared distance of a kept result is what the
+/// adaptive cutoff learns from.  With mixed precision the separated terms
+/// applied in single precision are counted as well.
+class ApplyStats {
+ public:
+  static const int nlevel = 64;
+
+ private:
+  typedef AtomicLevelArray<unsigned long, nlevel> counterT;
+  mutable counterT nsource_, nconsidered_, nscreened_, napplied_, ndiscarded_;
+  mutable counterT nsingle_;    ///< separated terms applied in single precision
+  mutable counterT maxdistsq_;  ///< largest squared distance of a kept result
+
+ public:
+  void reset() const {
+    for (int n = 0; n < nlevel; ++n) {
+      nsource_[n] = 0;
+      nconsidered_[n] = 0;
+      nscreened_[n] = 0;
+      napplied_[n] = 0;
+      ndiscarded_[n] = 0;
+      nsingle_[n] = 0;
+      maxdistsq_[n] = 0;
+    }
+  }
+
+  /// add the counts of the displacement loop of one source box at level n
+
+  /// Called once per source box so that the loop itself touches no atomics.
+  /// @param[in] maxdistsq  largest squared distance of a kept result
+  void add(Level n, unsigned long nconsidered, unsigned long nscreened,
+           unsigned long napplied, unsigned long ndiscarded,
+           unsigned long maxdistsq) const {
+    nsource_[n]++;
+    nconsidered_[n] += nconsidered;
+    nscreened_[n] += nscreened;
+    napplied_[n] += napplied;
+    ndiscarded_[n] += ndiscarded;
+    unsigned long old = maxdistsq_[n];
+    while (maxdistsq > old &&
+           !maxdistsq_[n].compare_exchange_weak(old, maxdistsq)) {
+    }
+  }
+
+  /// add the number of separated terms of one displacement applied in single precision
+  void add_single(Level n, unsigned long nsingle) const { nsingle_[n] += nsingle; }
+
+  unsigned long nsource(Level n) const { return nsource_[n]; }
+  unsigned long nconsidered(Level n) const { return nconsidered_[n]; }
+  unsigned long nscreened(Level n) const { return nscreened_[n]; }
+  unsigned long napplied(Level n) const { return napplied_[n]; }
+  unsigned long ndiscarded(Level n) const { return ndiscarded_[n]; }
+  unsigned long nkept(Level n) const { return napplied_[n] - ndiscarded_[n]; }
+  unsigned long maxdistsq(Level n) const { return maxdistsq_[n]; }
+  unsigned long nsingle(Level n) const { return nsingle_[n]; }
+
+  /// print the counters summed over all processes; collective
+  void print(World& world) const {
+    std::vector<double> v(6 * nlevel);
+    for (int n = 0; n < nlevel; ++n) {
+      v[6 * n] = nsource_[n];
+      v[6 * n + 1] = nconsidered_[n];
+      v[6 * n + 2] = nscreened_[n];
+      v[6 * n + 3] = napplied_[n];
+      v[6 * n + 4] = ndiscarded_[n];
+      v[6 * n + 5] = nsingle_[n];
+    }
+    world.gop.sum(v.data(), v.size());
+    if (world.rank() == 0) {
+      madness::print(
+          "apply statistics: level  sources  considered  screened  applied  "
+          "discarded  single");
+      for (int n = 0; n < nlevel; ++n) {
+        if (v[6 * n] == 0) continue;
+        printf("%24d %8.0f %11.0f %9.0f %8.0f %10.0f %7.0f\n", n, v[6 * n],
+               v[6 * n + 1], v[6 * n + 2], v[6 * n + 3], v[6 * n + 4],
+               v[6 * n + 5]);
+      }
+    }
+  }
+};
+
 /// Convolutions in separated form (including Gaussian)
 
 /* this stuff is very confusing, poorly commented, and extremely poorly named!
@@ -139,6 +246,12 @@ class SeparatedConvolution
   double mu_;
 
  private:
+  ApplyStats stats_;  ///< counters of the displacement loop in do_apply
+  bool adaptive_cutoff_ = false;  ///< use the cutoffs learned from stats_
+  bool mixed_precision_ = false;  ///< apply negligible terms in single precision
+  mutable AtomicLevelArray<unsigned long, ApplyStats::nlevel>
+      cutoff_distsq_;  ///< learned cutoff+1 per level, 0 if none
+
   mutable std::vector<ConvolutionND<Q, NDIM> >
       ops;  ///< ConvolutionND keeps data for 1 term, all dimensions, 1
             ///< displacement
@@ -168,6 +281,55 @@ class SeparatedConvolution
   const bool& destructive() const { return destructive_; }
 
   const double& gamma() const { return mu_; }
+
+  /// counters of the displacement loop of the apply
+  const ApplyStats& apply_stats() const { return stats_; }
+
+  /// learn per-level cutoffs for the displacement loop from earlier applications
+
+  /// Each application of the operator takes the cutoffs learned from all
+  /// previous ones (see learn_cutoff) as a hint: beyond the largest distance
+  /// that contributed before, the displacement loop stops at the first
+  /// displacement that fails the operator norm bound instead of after a
+  /// whole shell without contributions.  The error budget per contribution
+  /// is the same as without the hint, and a function that reaches further
+  /// than the learned distance is still applied as far as the norm bound
+  /// allows.  Meant for repeated application to similar functions, as in SCF
+  /// iterations.
+  bool& adaptive_cutoff() { return adaptive_cutoff_; }
+  const bool& adaptive_cutoff() const { return adaptive_cutoff_; }
+
+  /// apply terms that contribute little in single precision
+
+  /// A separated term of a displacement whose norm (see parts_norm) times the
+  /// single precision error (single_precision_error) is below the tolerance of
+  /// the term is applied with float blocks and transforms and accumulated into
+  /// the double result.  These are the distant displacements and the high
+  /// exponent terms, i.e. most of the work, while the near field stays in
+  /// double.  Only real operators on real functions in full rank are affected.
+  bool& mixed_precision() { return mixed_precision_; }
+  const bool& mixed_precision() const { return mixed_precision_; }
+
+  /// relative error of a term applied in single precision
+  static constexpr double single_precision_error = 1.e-6;
+
+  /// take the cutoffs from the counters of the applications done so far
+  void learn_cutoff() const {
+    for (int n = 0; n < ApplyStats::nlevel; ++n) {
+      if (stats_.nkept(n) == 0) continue;
+      cutoff_distsq_[n] = stats_.maxdistsq(n) + 1;
+    }
+  }
+
+  /// the learned cutoff at level n, if any
+
+  /// @param[out] maxdistsq  largest squared distance that contributed before,
+  ///                        unchanged if nothing was learned at this level
+  void get_cutoff(Level n, unsigned long& maxdistsq) const {
+    const unsigned long cutoff = cutoff_distsq_[n];
+    if (cutoff == 0) return;
+    maxdistsq = cutoff - 1;
+  }
   const double& mu() const { return mu_; }
 
  private:
@@ -186,6 +348,13 @@ class SeparatedConvolution
     const Q* VT;
   };
 
+  /// Transformation with the blocks converted to single precision
+  struct TransformationF {
+    long r;
+    const float* U;
+    const float* VT;
+  };
+
   //        /// return the right block of the upsampled operator (modified NS
   //        only)
   //
@@ -225,14 +394,17 @@ class SeparatedConvolution
   //        }
 
   /// accumulate into result
-  template <typename T, typename R>
+
+  /// The work arrays and the transformation may be single precision with a
+  /// double result, see muopxv_single
+  template <typename T, typename R, typename transT, typename resultT>
   void apply_transformation(long dimk,
-                            const Transformation trans[NDIM],
+                            const transT trans[NDIM],
                             const Tensor<T>& f,
                             Tensor<R>& work1,
                             Tensor<R>& work2,
                             const Q mufac,
-                            Tensor<R>& result) const {
+                            Tensor<resultT>& result) const {
     // PROFILE_MEMBER_FUNC(SeparatedConvolution); // Too fine grain for routine
     // profiling
     long size = 1;
@@ -282,7 +454,17 @@ class SeparatedConvolution
       }
     }
     // Assuming here that result is contiguous and aligned
-    aligned_axpy(size, result.ptr(), w1, mufac);
+    accumulate_result(size, result.ptr(), w1, mufac);
+  }
+
+  template <typename R>
+  static void accumulate_result(long n, R* MADNESS_RESTRICT a, const R* MADNESS_RESTRICT b, const Q s) {
+    aligned_axpy(n, a, b, s);
+  }
+
+  /// accumulate a single precision result in double precision
+  static void accumulate_result(long n, double* MADNESS_RESTRICT a, const float* MADNESS_RESTRICT b, const Q s) {
+    for (long i = 0; i < n; ++i) a[i] += s * b[i];
   }
 
   /// accumulate into result
@@ -359,6 +541,53 @@ class SeparatedConvolution
 #endif
   }
 
+  /// Choose the rank of the 1D blocks of one term, or the full blocks
+
+  /// @param[in]  r_term  the R (true) or the T (false) part of the term
+  /// @param[in]  tol     the relative tolerance of the term
+  /// @return false if the rank is zero in a dimension and the term vanishes
+  bool make_transformation(const ConvolutionData1D<Q>* const ops_1d[NDIM],
+                           bool r_term,
+                           double tol,
+                           Transformation trans[NDIM]) const {
+    long twok = 2 * k;
+    if (modified() or not r_term) twok = k;
+
+    long break_even;
+    if (NDIM == 1)
+      break_even = long(0.5 * twok);
+    else if (NDIM == 2)
+      break_even = long(0.6 * twok);
+    else if (NDIM == 3)
+      break_even = long(0.65 * twok);
+    else
+      break_even = long(0.7 * twok);
+    for (std::size_t d = 0; d < NDIM; ++d) {
+      const Tensor<double>& s = r_term ? ops_1d[d]->Rs : ops_1d[d]->Ts;
+      long r;
+      for (r = 0; r < twok; ++r) {
+        if (s[r] < tol) break;
+      }
+      if (r >= break_even) {
+        trans[d].r = twok;
+        trans[d].U = r_term ? ops_1d[d]->R.ptr() : ops_1d[d]->T.ptr();
+        trans[d].VT = 0;
+      } else {
+#ifdef USE_GENTENSOR
+        r = std::max(
+            2L,
+            r + (r & 1L));  // (needed for 6D == when GENTENSOR is on)
+                            // NOLONGER NEED TO FORCE OPERATOR RANK TO BE EVEN
+#endif
+        if (r == 0) return false;
+        trans[d].r = r;
+        trans[d].U = r_term ? ops_1d[d]->RU.ptr() : ops_1d[d]->TU.ptr();
+        trans[d].VT = r_term ? ops_1d[d]->RVT.ptr() : ops_1d[d]->TVT.ptr();
+      }
+    }
+    return true;
+  }
+
   /// Apply one of the separated terms, accumulating into the result
   template <typename T>
   void muopxv_fast(ApplyTerms at,
@@ -374,7 +603,6 @@ class SeparatedConvolution
     // PROFILE_MEMBER_FUNC(SeparatedConvolution); // Too fine grain for routine
     // profiling
     Transformation trans[NDIM];
-    Tensor<T> trans2[NDIM];
 
     double Rnorm = 1.0;
     for (std::size_t d = 0; d < NDIM; ++d) Rnorm *= ops_1d[d]->Rnorm;
@@ -382,53 +610,87 @@ class SeparatedConvolution
     if (at.r_term and (Rnorm > 1.e-20)) {
       tol = tol / (Rnorm * NDIM);  // Errors are relative within here
 
-      // Determine rank of SVD to use or if to use the full matrix
       long twok = 2 * k;
       if (modified()) twok = k;
 
-      long break_even;
-      if (NDIM == 1)
-        break_even = long(0.5 * twok);
-      else if (NDIM == 2)
-        break_even = long(0.6 * twok);
-      else if (NDIM == 3)
-        break_even = long(0.65 * twok);
-      else
-        break_even = long(0.7 * twok);
-      bool rank_is_zero = false;
+      if (make_transformation(ops_1d, true, tol, trans))
+        apply_transformation(twok, trans, f, work1, work2, mufac, result);
+    }
+
+    double Tnorm = 1.0;
+    for (std::size_t d = 0; d < NDIM; ++d) Tnorm *= ops_1d[d]->Tnorm;
+
+    if (at.t_term and (Tnorm > 0.0)) {
+      tol = tol / (Tnorm * NDIM);  // Errors are relative within here
+
+      if (make_transformation(ops_1d, false, tol, trans))
+        apply_transformation(k, trans, f0, work1, work2, -mufac, result0);
+    }
+  }
+
+  /// Norm of the larger of the R and T parts of a term, without the factor
+
+  /// The NS norm of a term is that of the difference of its parts, but
+  /// muopxv applies the parts separately and the rounding error of single
+  /// precision is relative to each of them.
+  double parts_norm(ApplyTerms at,
+                    const ConvolutionData1D<Q>* const ops_1d[NDIM]) const {
+    double prodR = 1.0, prodT = 1.0;
+    for (std::size_t d = 0; d < NDIM; ++d) {
+      prodR *= ops_1d[d]->Rnormf;
+      prodT *= ops_1d[d]->Tnormf;
+    }
+    return at.t_term ? std::max(prodR, prodT) : prodR;
+  }
+
+  /// Apply one of the separated terms in single precision, accumulating into
+  /// the double result
+
+  /// The blocks chosen by make_transformation are converted to float; for
+  /// NDIM>1 that costs little compared to the transforms themselves.
+  void muopxv_single(ApplyTerms at,
+                     const ConvolutionData1D<Q>* const ops_1d[NDIM],
+                     const Tensor<float>& f,
+                     const Tensor<float>& f0,
+                     Tensor<double>& result,
+                     Tensor<double>& result0,
+                     double tol,
+                     const Q mufac,
+                     Tensor<float>& work1,
+                     Tensor<float>& work2) const {
+    Transformation trans[NDIM];
+    TransformationF transf[NDIM];
+    Tensor<float> blocks[NDIM][2];
+
+    auto to_float = [&](long dimk) {
       for (std::size_t d = 0; d < NDIM; ++d) {
-        long r;
-        for (r = 0; r < twok; ++r) {
-          if (ops_1d[d]->Rs[r] < tol) break;
-        }
-        if (r >= break_even) {
-          trans[d].r = twok;
-          trans[d].U = ops_1d[d]->R.ptr();
-          trans[d].VT = 0;
-        } else {
-#ifdef USE_GENTENSOR
-          r = std::max(
-              2L,
-              r + (r & 1L));  // (needed for 6D == when GENTENSOR is on)
-                              // NOLONGER NEED TO FORCE OPERATOR RANK TO BE EVEN
-#endif
-          if (r == 0) {
-            rank_is_zero = true;
-            break;
-          }
-          trans[d].r = r;
-          trans[d].U = ops_1d[d]->RU.ptr();
-          trans[d].VT = ops_1d[d]->RVT.ptr();
+        const long size = dimk * dimk;
+        const Q* src[2] = {trans[d].U, trans[d].VT};
+        for (int i = 0; i < 2; ++i) {
+          if (not src[i]) continue;
+          if (blocks[d][i].size() != size) blocks[d][i] = Tensor<float>(dimk, dimk);
+          float* MADNESS_RESTRICT dst = blocks[d][i].ptr();
+          for (long j = 0; j < size; ++j) dst[j] = src[i][j];
         }
-        trans2[d] = ops_1d[d]->R;
+        transf[d].r = trans[d].r;
+        transf[d].U = blocks[d][0].ptr();
+        transf[d].VT = trans[d].VT ? blocks[d][1].ptr() : 0;
       }
+    };
 
-      if (!rank_is_zero)
-        apply_transformation(twok, trans, f, work1, work2, mufac, result);
+    double Rnorm = 1.0;
+    for (std::size_t d = 0; d < NDIM; ++d) Rnorm *= ops_1d[d]->Rnorm;
+
+    if (at.r_term and (Rnorm > 1.e-20)) {
+      tol = tol / (Rnorm * NDIM);  // Errors are relative within here
 
-      //            apply_transformation2(n, twok, tol, trans2, f, work1, work2,
-      //            mufac, result);
-      //                apply_transformation3(trans2, f, mufac, result);
+      long twok = 2 * k;
+      if (modified()) twok = k;
+
+      if (make_transformation(ops_1d, true, tol, trans)) {
+        to_float(twok);
+        apply_transformation(twok, transf, f, work1, work2, mufac, result);
+      }
     }
 
     double Tnorm = 1.0;
@@ -437,47 +699,10 @@ class SeparatedConvolution
     if (at.t_term and (Tnorm > 0.0)) {
       tol = tol / (Tnorm * NDIM);  // Errors are relative within here
 
-      long break_even;
-      if (NDIM == 1)
-        break_even = long(0.5 * k);
-      else if (NDIM == 2)
-        break_even = long(0.6 * k);
-      else if (NDIM == 3)
-        break_even = long(0.65 * k);
-      else
-        break_even = long(0.7 * k);
-      bool rank_is_zero = false;
-      for (std::size_t d = 0; d < NDIM; ++d) {
-        long r;
-        for (r = 0; r < k; ++r) {
-          if (ops_1d[d]->Ts[r] < tol) break;
-        }
-        if (r >= break_even) {
-          trans[d].r = k;
-          trans[d].U = ops_1d[d]->T.ptr();
-          trans[d].VT = 0;
-        } else {
-#ifdef USE_GENTENSOR
-          r = std::max(
-              2L,
-              r + (r & 1L));  // (needed for 6D == GENTENSOR is USED) NOLONGER
-                              // NEED TO FORCE OPERATOR RANK TO BE EVEN
-#endif
-          if (r == 0) {
-            rank_is_zero = true;
-            break;
-          }
-          trans[d].r = r;
-          trans[d].U = ops_1d[d]->TU.ptr();
-          trans[d].VT = ops_1d[d]->TVT.ptr();
-        }
-        trans2[d] = ops_1d[d]->T;
+      if (make_transformation(ops_1d, false, tol, trans)) {
+        to_float(k);
+        apply_transformation(k, transf, f0, work1, work2, -mufac, result0);
       }
-      if (!rank_is_zero)
-        apply_transformation(k, trans, f0, work1, work2, -mufac, result0);
-      //                apply_transformation2(n, k, tol, trans2, f0, work1,
-      //                work2, -mufac, result0); apply_transformation3(trans2,
-      //                f0, -mufac, result0);
     }
   }
 
@@ -1062,6 +1287,8 @@ class SeparatedConvolution
       double c = std::pow(sqrt(expnt(mu) / madness::constants::pi),
                           static_cast<int>(NDIM));  // Normalization coeff
       ops[mu].setfac(coeff(mu) / c);
+      // the phased operators are owned here, and only their lattice images
+      // are shared through GaussianConvolution1DCache
       for (std::size_t d = 0; d < NDIM; ++d) {
         double c2 =
             sqrt(expnt[mu] * width[d] * width[d] / madness::constants::pi);
@@ -1096,6 +1323,9 @@ class SeparatedConvolution
     }
   }
 
+  /// print the apply statistics summed over all processes; collective
+  void print_apply_stats() const { stats_.print(this->get_world()); }
+
   const BoundaryConditions<NDIM>& get_bc() const { return bc; }
 
   const std::vector<Key<NDIM> >& get_disp(Level n) const {
@@ -1232,6 +1462,11 @@ class SeparatedConvolution
     }
 
     const Tensor<T> f0 = copy(coeff(s0));
+
+    // input and work arrays of the terms applied in single precision
+    Tensor<float> input_f, f0_f, work1_f, work2_f;
+    unsigned long nsingle = 0;
+
     for (int mu = 0; mu < rank; ++mu) {
       // SeparatedConvolutionInternal keeps data for 1 term and all dimensions
       // and 1 displacement
@@ -1239,6 +1474,32 @@ class SeparatedConvolution
       if (muop.norm > tol) {
         // ops is of ConvolutionND, returns data for 1 term and all dimensions
         Q fac = ops[mu].getfac();
+        if constexpr (std::is_same<Q, double>::value and
+                      std::is_same<T, double>::value) {
+          if (mixed_precision() and
+              parts_norm(at, muop.ops) * std::abs(fac) *
+                      single_precision_error <
+                  tol) {
+            if (input_f.size() == 0) {
+              input_f = convert<float>(*input);
+              f0_f = convert<float>(f0);
+              work1_f = Tensor<float>(work1.ndim(), work1.dims(), false);
+              work2_f = Tensor<float>(work2.ndim(), work2.dims(), false);
+            }
+            muopxv_single(at,
+                          muop.ops,
+                          input_f,
+                          f0_f,
+                          r,
+                          r0,
+                          tol / std::abs(fac),
+                          fac,
+                          work1_f,
+                          work2_f);
+            ++nsingle;
+            continue;
+          }
+        }
         muopxv_fast(at,
                     muop.ops,
                     *input,
@@ -1253,6 +1514,7 @@ class SeparatedConvolution
     }
 
     r(s0).gaxpy(1.0, r0, 1.0);
+    if (nsingle) stats_.add_single(source.level(), nsingle);
     double cpu1 = cpu_time();
     timer_full.accumulate(cpu1 - cpu0);
 
@@ -0,0 +1,267 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+/// \file operator_block_store.cc
+/// \brief Implementation of the persistent store of 1D operator blocks
+
+#include <madness/mra/operator_block_store.h>
+#include <madness/world/worldmutex.h>
+#include <madness/world/print.h>
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace madness {
+
+    namespace {
+
+        typedef OperatorBlockStore::keyT keyT;
+
+        /// Identifies the file format; its length keeps the records 8-byte aligned
+        const char magic[8] = {'M','A','D','O','P','B','S','1'};
+
+        /// On-disk record header, followed by size doubles
+        struct recordT {
+            keyT key;
+            long size;
+        };
+
+        struct hasherT {
+            std::size_t operator()(const keyT& key) const {
+                return key.hash();
+            }
+        };
+
+        class storeT {
+            typedef std::unordered_map< keyT, std::pair<const double*,long>, hasherT > mappedT;
+            typedef std::unordered_map< keyT, std::vector<double>, hasherT > addedT;
+
+            std::string filename;
+            void* map;
+            std::size_t mapsize;
+            mappedT mapped;             ///< Blocks in the mapped file
+            addedT added;               ///< Blocks computed in this run
+            std::vector<keyT> pending;  ///< Blocks not yet written to the file
+            long nhit, nmiss;
+            Mutex mutex;
+
+            void unmap() {
+                if (map) munmap(map, mapsize);
+                map = 0;
+                mapsize = 0;
+                mapped.clear();
+            }
+
+            /// Collects the keys of the records in the open file fd of the given size
+            static void read_keys(int fd, off_t filesize, std::unordered_set<keyT,hasherT>& keys) {
+                off_t offset = sizeof(magic);
+                recordT rec;
+                while (offset + off_t(sizeof(rec)) <= filesize) {
+                    if (pread(fd, &rec, sizeof(rec), offset) != ssize_t(sizeof(rec))) break;
+                    offset += sizeof(rec);
+                    if (rec.size < 0 || offset + off_t(rec.size*sizeof(double)) > filesize) break;
+                    keys.insert(rec.key);
+                    offset += rec.size*sizeof(double);
+                }
+            }
+
+            void do_flush() {
+                if (filename.empty() || pending.empty()) return;
+                int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+                if (fd < 0) {
+                    print("OperatorBlockStore: cannot write", filename, "... blocks are not saved");
+                    pending.clear();
+                    return;
+                }
+                // Other processes on the node may append the same blocks at the
+                // same time, so skip those already in the file under the lock
+                flock(fd, LOCK_EX);
+                struct stat st;
+                bool ok = (fstat(fd, &st) == 0);
+                std::unordered_set<keyT,hasherT> present;
+                if (ok && st.st_size == 0) ok = (write(fd, magic, sizeof(magic)) == ssize_t(sizeof(magic)));
+                else if (ok) read_keys(fd, st.st_size, present);
+                for (std::size_t i=0; ok && i<pending.size(); ++i) {
+                    if (present.count(pending[i])) continue;
+                    const std::vector<double>& v = added[pending[i]];
+                    const recordT rec{pending[i], long(v.size())};
+                    ok = (write(fd, &rec, sizeof(rec)) == ssize_t(sizeof(rec)));
+                    ok = ok && (write(fd, v.data(), v.size()*sizeof(double)) == ssize_t(v.size()*sizeof(double)));
+                }
+                flock(fd, LOCK_UN);
+                ::close(fd);
+                if (!ok) print("OperatorBlockStore: failed writing", filename);
+                pending.clear();
+            }
+
+        public:
+            storeT() : map(0), mapsize(0), nhit(0), nmiss(0) {}
+
+            // Blocks are only written by an explicit flush() or close(), not
+            // at static destruction when the runtime is already gone
+            ~storeT() {
+                unmap();
+            }
+
+            void open(const std::string& name) {
+                close();
+                ScopedMutex<Mutex> obolus(mutex);
+                filename = name;
+                nhit = nmiss = 0;
+                int fd = ::open(filename.c_str(), O_RDONLY);
+                if (fd < 0) return; // created on the first flush
+                struct stat st;
+                if (fstat(fd, &st) == 0 && st.st_size > long(sizeof(magic))) {
+                    mapsize = st.st_size;
+                    map = mmap(0, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+                    if (map == MAP_FAILED) {
+                        map = 0;
+                        mapsize = 0;
+                    }
+                }
+                ::close(fd);
+                if (!map) return;
+
+                const char* p = static_cast<const char*>(map);
+                if (std::memcmp(p, magic, sizeof(magic)) != 0) {
+                    print("OperatorBlockStore: ignoring", filename, "... not a block store");
+                    unmap();
+                    filename.clear();
+                    return;
+                }
+                // A record cut short by an interrupted writer ends the scan
+                std::size_t offset = sizeof(magic);
+                while (offset + sizeof(recordT) <= mapsize) {
+                    recordT rec;
+                    std::memcpy(&rec, p+offset, sizeof(rec));
+                    offset += sizeof(recordT);
+                    if (rec.size < 0 || offset + rec.size*sizeof(double) > mapsize) break;
+                    mapped.insert(std::make_pair(rec.key, std::make_pair(reinterpret_cast<const double*>(p+offset), rec.size)));
+                    offset += rec.size*sizeof(double);
+                }
+            }
+
+            void close() {
+                ScopedMutex<Mutex> obolus(mutex);
+                do_flush();
+                unmap();
+                added.clear();
+                filename.clear();
+            }
+
+            void flush() {
+                ScopedMutex<Mutex> obolus(mutex);
+                do_flush();
+            }
+
+            bool enabled() const {
+                return !filename.empty();
+            }
+
+            bool find(const keyT& key, Tensor<double>& v) {
+                ScopedMutex<Mutex> obolus(mutex);
+                mappedT::const_iterator it = mapped.find(key);
+                if (it != mapped.end()) {
+                    v = Tensor<double>(it->second.second);
+                    std::memcpy(v.ptr(), it->second.first, it->second.second*sizeof(double));
+                    ++nhit;
+                    return true;
+                }
+                addedT::const_iterator ia = added.find(key);
+                if (ia != added.end()) {
+                    v = Tensor<double>(long(ia->second.size()));
+                    std::memcpy(v.ptr(), ia->second.data(), ia->second.size()*sizeof(double));
+                    ++nhit;
+                    return true;
+                }
+                ++nmiss;
+                return false;
+            }
+
+            void insert(const keyT& key, const Tensor<double>& v) {
+                MADNESS_ASSERT(v.iscontiguous());
+                ScopedMutex<Mutex> obolus(mutex);
+                if (filename.empty() || mapped.count(key) || added.count(key)) return;
+                added[key] = std::vector<double>(v.ptr(), v.ptr()+v.size());
+                pending.push_back(key);
+            }
+
+            void get_stats(long& hit, long& miss) {
+                ScopedMutex<Mutex> obolus(mutex);
+                hit = nhit;
+                miss = nmiss;
+            }
+        };
+
+        storeT& get_store() {
+            static storeT store;
+            return store;
+        }
+    }
+
+    void OperatorBlockStore::open(const std::string& filename) {
+        get_store().open(filename);
+    }
+
+    void OperatorBlockStore::close() {
+        get_store().close();
+    }
+
+    void OperatorBlockStore::flush() {
+        get_store().flush();
+    }
+
+    bool OperatorBlockStore::enabled() {
+        return get_store().enabled();
+    }
+
+    bool OperatorBlockStore::find(const keyT& key, Tensor<double>& v) {
+        return get_store().find(key, v);
+    }
+
+    void OperatorBlockStore::insert(const keyT& key, const Tensor<double>& v) {
+        get_store().insert(key, v);
+    }
+
+    void OperatorBlockStore::get_stats(long& nhit, long& nmiss) {
+        get_store().get_stats(nhit, nmiss);
+    }
+}
@@ -0,0 +1,128 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+
+#ifndef MADNESS_MRA_OPERATOR_BLOCK_STORE_H__INCLUDED
+#define MADNESS_MRA_OPERATOR_BLOCK_STORE_H__INCLUDED
+
+#include <madness/tensor/tensor.h>
+#include <madness/mra/key.h>
+#include <string>
+
+/// \file operator_block_store.h
+/// \brief Opt-in persistent on-disk store of 1D operator blocks
+
+namespace madness {
+
+    /// Persistent store of the 1D blocks of convolution operators
+
+    /// Computing the projection of a kernel onto the double order Legendre
+    /// polynomials (Convolution1D::rnlp) dominates operator setup at high k and
+    /// deep levels.  The store keeps these blocks in a file that later runs, and
+    /// other processes on the same node, map read-only instead of recomputing
+    /// them.  Blocks computed during a run are appended to the file by flush()
+    /// or close(), skipping blocks that another process has appended meanwhile.
+    ///
+    /// The store is disabled unless open() is called, or the environment
+    /// variable MAD_OPERATOR_CACHE names the file when startup() runs; in the
+    /// latter case finalize() closes it.  Only real blocks are stored.
+    class OperatorBlockStore {
+    public:
+        /// Kind of kernel a block belongs to
+        enum kernelT {GAUSSIAN=1};
+
+        /// Identifies a block: kernel, its parameters, order, level and displacement
+        struct keyT {
+            int kernel;
+            int k;
+            int npt;
+            int m;
+            double expnt;
+            double coeff;
+            Level n;
+            Translation lx;
+
+            keyT() : kernel(0), k(0), npt(0), m(0), expnt(0.0), coeff(0.0), n(0), lx(0) {}
+
+            keyT(kernelT kernel, int k, int npt, int m, double expnt, double coeff, Level n, Translation lx)
+                : kernel(kernel), k(k), npt(npt), m(m), expnt(expnt), coeff(coeff), n(n), lx(lx) {}
+
+            bool operator==(const keyT& other) const {
+                return kernel==other.kernel && k==other.k && npt==other.npt && m==other.m &&
+                    expnt==other.expnt && coeff==other.coeff && n==other.n && lx==other.lx;
+            }
+
+            hashT hash() const {
+                hashT h = hash_value(expnt);
+                hash_combine(h, coeff);
+                hash_combine(h, kernel);
+                hash_combine(h, k);
+                hash_combine(h, npt);
+                hash_combine(h, m);
+                hash_combine(h, n);
+                hash_combine(h, lx);
+                return h;
+            }
+        };
+
+        /// Maps the store file, or creates it on the first flush if it does not exist
+        static void open(const std::string& filename);
+
+        /// Appends the new blocks to the file and unmaps it; the store is disabled afterwards
+        static void close();
+
+        /// Appends the blocks computed since the last flush to the file
+        static void flush();
+
+        /// True if a store file is in use
+        static bool enabled();
+
+        /// Copies a stored block into v (of the stored size); returns false if absent
+        static bool find(const keyT& key, Tensor<double>& v);
+
+        /// Complex blocks are not stored
+        static bool find(const keyT& /*key*/, Tensor<double_complex>& /*v*/) {
+            return false;
+        }
+
+        /// Remembers a newly computed block for the next flush
+        static void insert(const keyT& key, const Tensor<double>& v);
+
+        /// Complex blocks are not stored
+        static void insert(const keyT& /*key*/, const Tensor<double_complex>& /*v*/) {}
+
+        /// Number of blocks found in and added to the store since open
+        static void get_stats(long& nhit, long& nmiss);
+    };
+}
+
+#endif // MADNESS_MRA_OPERATOR_BLOCK_STORE_H__INCLUDED
@@ -35,6 +35,7 @@
 #include <madness/mra/adquad.h>
 #include <madness/misc/cfft.h>
 #include <madness/misc/interpolation_1d.h>
+#include <madness/tensor/vmath.h>
 #include <cmath>
 #include <complex>
 #include <madness/constants.h>
@@ -56,13 +57,6 @@ namespace madness {
         double xmax;
         CubicInterpolationTable<double_complex> fit;
 
-        double_complex g0_filtered(double k, double c, double t) {
-            double r = k/c;
-            if (fabs(r) > 4.0) return 0.0;
-            double_complex arg(0.0, -k*k*t*0.5);
-            return exp(arg)/(1.0 + pow(r,30.0));
-        }
-
     public:
         typedef double_complex returnT;
 
@@ -94,10 +88,19 @@ namespace madness {
             
             std::vector<double_complex> s(N);
 
-            for (int i=0; i<N/2; ++i) {
+            // the filtered propagator exp(-i k^2 t/2)/(1+(k/c)^30) is even
+            // in k and zero beyond |k|=4c; the phase factors are computed
+            // in one pass with the vector exp
+            const int nk = std::min(N/2, int(4.0*c/hk) + 1);
+            for (int i=0; i<nk; ++i) {
                 double k = i*hk;
-                s[i] = g0_filtered(k, c, t)*fac;
-                if (i) s[N-i] = g0_filtered(-k, c, t)*fac;
+                s[i] = double_complex(0.0, -k*k*t*0.5);
+            }
+            vexp(nk, &s[0], &s[0]);
+            for (int i=0; i<nk; ++i) {
+                double r = i*hk/c;
+                s[i] = (r > 4.0) ? 0.0 : s[i]*fac/(1.0 + pow(r,30.0));
+                if (i) s[N-i] = s[i];
             }
 
             CFFT::Inverse(&s[0], N);
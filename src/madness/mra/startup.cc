@@ -38,6 +38,7 @@
 #include <madness/mra/mra.h>
 #include <madness/tensor/tensor.h>
 #include <madness/world/timers.h>
+#include <madness/mra/operator_block_store.h>
 //#include <madness/mra/mraimpl.h> !!!!!!!!!!!!!!!!  NOOOOOOOOOOOOOOOOOOOOOOOOOO !!!!!!!!!!!!!!!!!!!!!!!
 #include <iomanip>
 #include <cstdlib>
@@ -62,7 +63,7 @@ namespace madness {
 
 
     void startup(World& world, int argc, char** argv, bool doprint) {
-        const char* data_dir = MRA_DATA_DIR;
+        const char* data_dir = 0; // use the tables compiled into the library
 
         // Process command line arguments
         for (int arg=1; arg<argc; ++arg) {
@@ -81,9 +82,15 @@ namespace madness {
                 redirectio(world);
         }
 
-        // Process environment variables
+        // Process environment variables ... MRA_DATA_DIR overrides the embedded tables
         if (getenv("MRA_DATA_DIR")) data_dir = getenv("MRA_DATA_DIR");
 
+        // ... MAD_OPERATOR_CACHE names a file to keep operator blocks between runs
+        if (getenv("MAD_OPERATOR_CACHE")) {
+            OperatorBlockStore::open(getenv("MAD_OPERATOR_CACHE"));
+            at_finalize(&OperatorBlockStore::close);
+        }
+
         // Need to add an RC file ...
 
         world.gop.fence();
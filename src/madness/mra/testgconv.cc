@@ -37,7 +37,9 @@
 
 #include <madness/mra/mra.h>
 #include <madness/mra/operator.h>
+#include <madness/mra/operator_block_store.h>
 #include <madness/constants.h>
+#include <cstdio>
 
 using namespace madness;
 
@@ -175,6 +177,100 @@ int test_gconv(World& world) {
 }
 
 
+/// operator blocks read back from the persistent store reproduce the computed ones
+int test_operator_block_store(World& world) {
+    double width = 2.0*L;
+    int success=0;
+
+    if (world.rank() == 0) print("Test operator block store");
+
+    const real_function_1d f = real_factory_1d(world).f(g);
+    std::vector< std::shared_ptr< Convolution1D<double> > > ops(1);
+    ops[0].reset(new GaussianConvolution1D<double>(k, width/sqrt(constants::pi),
+            width*width, 0, false));
+    const real_function_1d ref = real_convolution_1d(world, ops)(f);
+
+    const std::string filename = "testgconv_blocks." + std::to_string(world.rank());
+    std::remove(filename.c_str());
+
+    // the first pass fills the store, the second one reads all blocks back
+    for (int pass=0; pass<2; ++pass) {
+        OperatorBlockStore::open(filename);
+        ops[0].reset(new GaussianConvolution1D<double>(k, width/sqrt(constants::pi),
+                width*width, 0, false));
+        real_function_1d opf = real_convolution_1d(world, ops)(f);
+        world.gop.fence();
+        long nhit, nmiss;
+        OperatorBlockStore::get_stats(nhit, nmiss);
+        OperatorBlockStore::close();
+
+        double error = (opf - ref).norm2();
+        print("pass", pass, "blocks found", nhit, "computed", nmiss, "error", error);
+        if (error > 1.e-14) success++;
+        if (pass == 1 and (nmiss != 0 or nhit == 0)) success++;
+    }
+    std::remove(filename.c_str());
+    print("success 7 ", success);
+
+    world.gop.fence();
+    return success;
+}
+
+
+/// the adaptive displacement cutoff keeps the accuracy and does not apply more than before
+int test_adaptive_cutoff(World& world) {
+    double width = 2.0*L;
+    int success=0;
+
+    if (world.rank() == 0) print("Test adaptive displacement cutoff");
+
+    const real_function_1d f = real_factory_1d(world).f(g);
+    std::vector< std::shared_ptr< Convolution1D<double> > > ops(1);
+    ops[0].reset(new GaussianConvolution1D<double>(k, width/sqrt(constants::pi),
+            width*width, 0, false));
+    real_convolution_1d op(world, ops);
+
+    // counters are cumulative, the adaptive cutoff learns from all earlier applications
+    auto count = [&op](unsigned long& napplied, unsigned long& nkept) {
+        napplied=0;
+        nkept=0;
+        for (int n=0; n<ApplyStats::nlevel; ++n) {
+            napplied += op.apply_stats().napplied(n);
+            nkept += op.apply_stats().nkept(n);
+        }
+    };
+
+    const real_function_1d ref = op(f);
+    unsigned long napplied, nkept;
+    count(napplied, nkept);
+
+    op.adaptive_cutoff() = true;
+    unsigned long ntotal=napplied, nkepttotal=nkept;
+    for (int iter=0; iter<2; ++iter) {
+        real_function_1d opf = op(f);
+        unsigned long napplied1, nkept1;
+        count(napplied1, nkept1);
+        napplied1 -= ntotal;
+        nkept1 -= nkepttotal;
+        ntotal += napplied1;
+        nkepttotal += nkept1;
+
+        double error = (opf - ref).norm2();
+        print("adaptive cutoff: applied", napplied1, "of", napplied, "kept", nkept1, "of", nkept,
+              "error", error);
+        if (error > FunctionDefaults<1>::get_thresh()) success++;
+        if (napplied1 > napplied) success++;
+        napplied = napplied1;
+        nkept = nkept1;
+    }
+    op.print_apply_stats();
+    print("success 8 ", success);
+
+    world.gop.fence();
+    return success;
+}
+
+
 int main(int argc, char**argv) {
     initialize(argc,argv);
     World world(SafeMPI::COMM_WORLD);
@@ -193,6 +289,8 @@ int main(int argc, char**argv) {
         	print(" polynomial ", k,"\n");
         }
         success+=test_gconv(world);
+        success+=test_operator_block_store(world);
+        success+=test_adaptive_cutoff(world);
 
     }
     catch (const SafeMPI::Exception& e) {
@@ -0,0 +1,106 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/// \file testmacrotask.cc
+/// \brief tests the execution of macro tasks in subworlds
+
+#include <madness/mra/mra.h>
+#include <madness/mra/macrotaskq.h>
+
+using namespace madness;
+
+static double gauss(const coord_3d& r) {
+    return exp(-(r[0]*r[0] + 2.0*r[1]*r[1] + 3.0*r[2]*r[2]));
+}
+
+/// squares the input function i and stores it with its norm
+class square_task : public MacroTaskBase {
+    long i, n;
+public:
+    square_task(const long i, const long n) : i(i), n(n) {}
+
+    void run(World& subworld, Cloud& cloud) {
+        real_function_3d f = cloud.load<real_function_3d>(subworld, i);
+        real_function_3d fsq = square(f);
+        cloud.store(subworld, fsq, n+i);
+        cloud.store(subworld, fsq.norm2(), 2*n+i);
+    }
+};
+
+int test_macrotask(World& universe, const int nsubworld) {
+    const long n = 5;
+    int nfail = 0;
+
+    std::vector<real_function_3d> f(n);
+    for (long i=0; i<n; ++i) {
+        f[i] = real_factory_3d(universe).f(gauss);
+        f[i].scale(double(i+1));
+    }
+
+    Cloud cloud(universe);
+    for (long i=0; i<n; ++i) cloud.store(universe, f[i], i);
+
+    std::vector< std::shared_ptr<MacroTaskBase> > tasks;
+    for (long i=0; i<n; ++i) tasks.push_back(std::shared_ptr<MacroTaskBase>(new square_task(i,n)));
+
+    MacroTaskQ taskq(universe, nsubworld);
+    taskq.run_all(tasks, cloud);
+
+    for (long i=0; i<n; ++i) {
+        real_function_3d fsq = cloud.load<real_function_3d>(universe, n+i);
+        const double norm = cloud.load<double>(universe, 2*n+i);
+        const double err = (fsq - square(f[i])).norm2();
+        const double normerr = std::abs(norm - fsq.norm2());
+        if (universe.rank() == 0) print("task", i, "error", err, normerr);
+        if (err > 1.e-12 or normerr > 1.e-12) ++nfail;
+    }
+    cloud.clear();
+    return nfail;
+}
+
+int main(int argc, char** argv) {
+    initialize(argc, argv);
+    World world(SafeMPI::COMM_WORLD);
+    startup(world, argc, argv);
+
+    FunctionDefaults<3>::set_k(6);
+    FunctionDefaults<3>::set_thresh(1.e-5);
+    FunctionDefaults<3>::set_cubic_cell(-10, 10);
+
+    int nfail = 0;
+    nfail += test_macrotask(world, 1);
+    if (world.size() > 1) nfail += test_macrotask(world, 2);
+
+    if (world.rank() == 0) print(nfail ? "macrotask test FAILED" : "macrotask test OK");
+    world.gop.fence();
+    finalize();
+    return nfail;
+}
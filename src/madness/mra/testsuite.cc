@@ -92,6 +92,28 @@ public:
     };
 };
 
+/// Same as Gaussian but projected through the vectorized interface
+template <typename T, std::size_t NDIM>
+class VectorizedGaussian : public Gaussian<T,NDIM> {
+public:
+    typedef Vector<double,NDIM> coordT;
+
+    VectorizedGaussian(const coordT& center, double exponent, T coefficient)
+            : Gaussian<T,NDIM>(center, exponent, coefficient) {};
+
+    using Gaussian<T,NDIM>::operator();
+
+    bool supports_vectorized() const {return true;}
+
+    void operator()(const Vector<double*,NDIM>& xvals, T* fvals, int npts) const {
+        for (int i=0; i<npts; ++i) {
+            coordT x;
+            for (std::size_t d=0; d<NDIM; ++d) x[d] = xvals[d][i];
+            fvals[i] = (*this)(x);
+        }
+    };
+};
+
 template <typename T, std::size_t NDIM>
 class DerivativeGaussian : public FunctionFunctorInterface<T,NDIM> {
 public:
@@ -222,6 +244,32 @@ int test_basic(World& world) {
     CHECK(err, 3*thresh, "err");
     CHECK(val-(*functor)(point), thresh, "error at a point");
 
+    std::vector<coordT> points(50);
+    for (std::size_t j=0; j<points.size(); ++j) {
+        for (std::size_t i=0; i<NDIM; ++i) points[j][i] = cell(i,0) + (cell(i,1)-cell(i,0))*(j+0.25*i)/(points.size()+1.0);
+    }
+    points.back() = coordT(0.0);
+    for (std::size_t i=0; i<NDIM; ++i) points.back()[i] = cell(i,1);
+    std::vector<T> vals = f.eval(points).get();
+    double batcherr = 0.0;
+    for (std::size_t j=0; j<points.size(); ++j) batcherr = std::max(batcherr, double(std::abs(vals[j]-f(points[j]))));
+    CHECK(batcherr, 1e-12, "error in batched evaluation");
+
+    Function<T,NDIM> fv = FunctionFactory<T,NDIM>(world).functor(functorT(new VectorizedGaussian<T,NDIM>(origin, expnt, coeff)));
+    CHECK((f-fv).norm2(), 1e-12, "err in vectorized projection");
+
+    std::vector<functorT> functors;
+    functors.push_back(functor);
+    functors.push_back(functorT(new Gaussian<T,NDIM>(point, 3.0*expnt, coeff)));
+    functors.push_back(functorT(new VectorizedGaussian<T,NDIM>(point, 0.5*expnt, coeff)));
+    std::vector< Function<T,NDIM> > fmulti = project_functors(world, functors, FunctionFactory<T,NDIM>(world));
+    double multierr = 0.0;
+    for (std::size_t i=0; i<functors.size(); ++i) {
+        Function<T,NDIM> fi = FunctionFactory<T,NDIM>(world).functor(functors[i]);
+        multierr = std::max(multierr, (fi-fmulti[i]).norm2());
+    }
+    CHECK(multierr, 1e-12, "err in multi-functor projection");
+
     f.compress();
     double new_norm = f.norm2();
     CHECK(new_norm-norm, 1e-14, "new_norm");
@@ -543,6 +591,27 @@ int test_math(World& world) {
         if (world.rank() == 0) print("\nTest DONE multi", moperr);
     }
 
+    if (world.rank() == 0) print("\nTest lazy expression evaluation");
+    {
+        functorT f1(RandomGaussian<T,NDIM>(FunctionDefaults<NDIM>::get_cell(),100.0));
+        functorT f2(RandomGaussian<T,NDIM>(FunctionDefaults<NDIM>::get_cell(),100.0));
+        functorT f3(RandomGaussian<T,NDIM>(FunctionDefaults<NDIM>::get_cell(),100.0));
+        Function<T,NDIM> a = FunctionFactory<T,NDIM>(world).functor(f1);
+        Function<T,NDIM> b = FunctionFactory<T,NDIM>(world).functor(f2);
+        Function<T,NDIM> c = FunctionFactory<T,NDIM>(world).functor(f3);
+        const T alpha(2.0), beta(-0.5);
+
+        Function<T,NDIM> ref = a*alpha + b*c*beta - a*b;
+        const std::size_t asize = a.tree_size(), bsize = b.tree_size(), csize = c.tree_size();
+        Function<T,NDIM> r = lazy(a)*alpha + lazy(b)*c*beta - lazy(a)*b;
+        r.verify_tree();
+        double experr = (r - ref).norm2();
+        CHECK(experr, 1e-8, "err in lazy expression");
+        // the operands are refined on the fly, not in place
+        const bool same = (a.tree_size() == asize) && (b.tree_size() == bsize) && (c.tree_size() == csize);
+        CHECK(same ? 0.0 : 1.0, 0.5, "lazy expression modified its operands");
+    }
+
     if (world.rank() == 0) print("\nTest adding random functions out of place");
     for (int i=0; i<10; ++i) {
         functorT f1(RandomGaussian<T,NDIM>(FunctionDefaults<NDIM>::get_cell(),100.0));
@@ -661,6 +730,28 @@ int test_diff(World& world) {
 
         if (world.rank() == 0) print("    error", err);
     }
+
+    {
+        std::vector< std::shared_ptr< Derivative<T,NDIM> > > grad = gradient_operator<T,NDIM>(world);
+        START_TIMER;
+        std::vector< Function<T,NDIM> > g = apply(grad, f, true);
+        END_TIMER("fused grad");
+        double err = 0.0;
+        for (std::size_t axis=0; axis<NDIM; ++axis) {
+            Function<T,NDIM> dfdx = (*grad[axis])(f);
+            err = std::max(err, (g[axis] - dfdx).norm2());
+        }
+        CHECK(err, 1.e-12, "err in fused gradient");
+
+        // a batch sharing one halo fence, with a repeated function
+        std::vector< Function<T,NDIM> > v(2, f);
+        std::vector< std::vector< Function<T,NDIM> > > dv = apply_derivatives(world, grad, v);
+        err = 0.0;
+        for (std::size_t axis=0; axis<NDIM; ++axis) {
+            for (std::size_t j=0; j<v.size(); ++j) err = std::max(err, (dv[axis][j] - g[axis]).norm2());
+        }
+        CHECK(err, 1.e-12, "err in batched gradient");
+    }
     world.gop.fence();
     if (not ok) return 1;
     return 0;
@@ -766,6 +857,19 @@ int test_op(World& world) {
     }
     CHECK(re, 30*thresh, "err in test_op");
 
+    // terms below the single precision error are applied in float
+    op.apply_stats().reset();
+    op.mixed_precision() = true;
+    Function<T,NDIM> rmixed = madness::apply(op,f);
+    op.mixed_precision() = false;
+    double emixed = (rmixed - r).norm2();
+    double nsingle = 0.0;
+    for (int n=0; n<ApplyStats::nlevel; ++n) nsingle += op.apply_stats().nsingle(n);
+    world.gop.sum(nsingle);
+    if (world.rank() == 0) print("  mixed precision op*f difference", emixed, "terms in float", nsingle);
+    CHECK(emixed, thresh, "err in mixed precision test_op");
+    if (std::is_same<T,double>::value) CHECK(nsingle == 0.0 ? 1.0 : 0.0, 0.5, "no terms in float in test_op");
+
 //     for (int i=0; i<=100; ++i) {
 //         coordT c(-10.0+20.0*i/100.0);
 //         print("           ",i,c[0],r(c),r(c)-(*fexact)(c));
@@ -190,6 +190,124 @@ void test_inner(World& world) {
         print("error norm",(rold-rnew).normf(),"\n");
 }
 
+template <typename T, int NDIM, bool sym>
+void test_inner_distributed(World& world) {
+    typedef std::shared_ptr< FunctionFunctorInterface<T,NDIM> > ffunctorT;
+
+    const double thresh=1.e-7;
+    Tensor<double> cell(NDIM,2);
+    for (std::size_t i=0; i<NDIM; ++i) {
+        cell(i,0) = -11.0-2*i;  // Deliberately asymmetric bounding box
+        cell(i,1) =  10.0+i;
+    }
+    FunctionDefaults<NDIM>::set_cell(cell);
+    FunctionDefaults<NDIM>::set_k(8);
+    FunctionDefaults<NDIM>::set_thresh(thresh);
+    FunctionDefaults<NDIM>::set_refine(true);
+    FunctionDefaults<NDIM>::set_initial_level(3);
+    FunctionDefaults<NDIM>::set_truncate_mode(1);
+
+    const int nleft=95, nright=sym ? nleft : 94;
+
+    if (world.rank() == 0)
+        print("testing distributed matrix_inner<",archive::get_type_name<T>(),">","sym =",sym);
+
+    // Tight Gaussians so that many pairs do not overlap
+    START_TIMER;
+    std::vector< Function<T,NDIM> > left(nleft), right(nright);
+    for (int i=0; i<nleft; ++i) {
+        ffunctorT f(RandomGaussian<T,NDIM>(FunctionDefaults<NDIM>::get_cell(),100.0));
+        left[i] = FunctionFactory<T,NDIM>(world).functor(f);
+    }
+    for (int i=0; i<nright && !sym; ++i) {
+        ffunctorT f(RandomGaussian<T,NDIM>(FunctionDefaults<NDIM>::get_cell(),100.0));
+        right[i] = FunctionFactory<T,NDIM>(world).functor(f);
+    }
+    const std::vector< Function<T,NDIM> >& g = sym ? left : right;
+    compress(world,left);
+    compress(world,g);
+    END_TIMER("project");
+
+    START_TIMER;
+    Tensor<T> rref = matrix_inner(world,left,g,sym);
+    END_TIMER("replicated");
+
+    Tensor<T> r(nleft,nright);
+    // tol bounds the error of each element, whatever the number of boxes
+    for (double tol : {0.0, 0.01*thresh, thresh}) {
+        START_TIMER;
+        DistributedMatrix<T> A = matrix_inner(column_distributed_matrix_distribution(world,nleft,nright),
+                                              left,g,sym,tol);
+        END_TIMER("distributed");
+        A.copy_to_replicated(r);
+        double err = (r-rref).absmax();
+        if (world.rank() == 0) print("tol",tol,"largest error",err,"\n");
+        MADNESS_CHECK(err < std::max(1.e-12,tol));
+    }
+}
+
+template <typename T, typename R, int NDIM>
+void test_transform(World& world) {
+    typedef std::shared_ptr< FunctionFunctorInterface<T,NDIM> > ffunctorT;
+    typedef TENSOR_RESULT_TYPE(T,R) resultT;
+
+    const double thresh=1.e-7;
+    Tensor<double> cell(NDIM,2);
+    for (std::size_t i=0; i<NDIM; ++i) {
+        cell(i,0) = -11.0-2*i;  // Deliberately asymmetric bounding box
+        cell(i,1) =  10.0+i;
+    }
+    FunctionDefaults<NDIM>::set_cell(cell);
+    FunctionDefaults<NDIM>::set_k(8);
+    FunctionDefaults<NDIM>::set_thresh(thresh);
+    FunctionDefaults<NDIM>::set_refine(true);
+    FunctionDefaults<NDIM>::set_initial_level(3);
+    FunctionDefaults<NDIM>::set_truncate_mode(1);
+
+    // More outputs than fit in one block, with a block of zeros in c
+    const int n=40, m=150;
+
+    if (world.rank() == 0)
+        print("testing transform<",archive::get_type_name<T>(),",",archive::get_type_name<R>(),">");
+
+    START_TIMER;
+    std::vector< Function<T,NDIM> > v(n);
+    for (int i=0; i<n; ++i) {
+        ffunctorT f(RandomGaussian<T,NDIM>(FunctionDefaults<NDIM>::get_cell(),100.0));
+        v[i] = FunctionFactory<T,NDIM>(world).functor(f);
+    }
+    compress(world,v);
+    END_TIMER("project");
+
+    Tensor<R> c(n,m);
+    c.fillrandom();
+    c(Slice(0,n/2-1),Slice(64,127)) = R(0.0);
+    world.gop.broadcast(c.ptr(), c.size(), 0);
+
+    START_TIMER;
+    std::vector< Function<resultT,NDIM> > vref = transform(world,v,c);
+    END_TIMER("gaxpy");
+
+    // the block transform screens each (input,output) pair as the transform
+    // one input at a time does, so the two agree at any tol
+    for (double tol : {0.0, thresh}) {
+        START_TIMER;
+        std::vector< Function<resultT,NDIM> > vc = transform(world,v,c,tol,true);
+        END_TIMER("transform");
+
+        std::vector< Function<resultT,NDIM> > vdoit = zero_functions_compressed<resultT,NDIM>(world,m);
+        std::vector< std::shared_ptr< FunctionImpl<resultT,NDIM> > > vleft(m);
+        for (int i=0; i<m; ++i) vleft[i] = vdoit[i].get_impl();
+        for (int j=0; j<n; ++j) vleft[0]->vtransform_doit(v[j].get_impl(), copy(c(j,_)), vleft, tol);
+        world.gop.fence();
+
+        double err = norm2(world,sub(world,vc,vdoit));
+        if (world.rank() == 0) print("tol",tol,"error norm",err,"\n");
+        MADNESS_CHECK(err < 1.e-12);
+        if (tol == 0.0) MADNESS_CHECK(norm2(world,sub(world,vc,vref)) < 1.e-12);
+    }
+}
+
 template <typename T, typename R, int NDIM>
 void test_cross(World& world) {
     typedef std::shared_ptr< FunctionFunctorInterface<T,NDIM> > ffunctorT;
@@ -364,6 +482,9 @@ int main(int argc, char**argv) {
 
         test_inner<double,double,1,false>(world);
         test_inner<double,double,1,true>(world);
+        test_inner_distributed<double,1,false>(world);
+        test_inner_distributed<double,1,true>(world);
+        test_transform<double,double,1>(world);
         test_multi_to_multi_op<1>(world);
         test_multi_to_multi_op<2>(world);
 
@@ -381,6 +502,8 @@ int main(int argc, char**argv) {
             test_inner<std::complex<double>,double,1,false>(world);
             test_inner<std::complex<double>,std::complex<double>,1,false>(world);
             test_inner<std::complex<double>,std::complex<double>,1,true>(world);
+            test_inner_distributed<std::complex<double>,1,true>(world);
+            test_transform<std::complex<double>,double,1>(world);
         }
 #endif
     }
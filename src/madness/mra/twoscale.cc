@@ -41,6 +41,7 @@ using std::ios;
 using std::abs;
 
 #include <madness/mra/twoscale.h>
+#include <madness/mra/data_table.h>
 #include <madness/tensor/tensor.h>
 #include <madness/misc/misc.h>
 
@@ -50,8 +51,8 @@ using std::abs;
 namespace madness {
 
     static const int kmax = 60;
-    static const char *twoscale_filename = "coeffs";  // Will be overridden by load_coeffs
-    static const char *autocorr_filename = "autocorr";  // Will be overriden by load_coeff
+    static const char *twoscale_filename = 0;  // Set by load_coeffs to override the embedded table
+    static const char *autocorr_filename = 0;  // Set by load_coeffs to override the embedded table
 
 
     static class twoscale_cache_class {
@@ -67,12 +68,12 @@ namespace madness {
     static bool loaded = 0;
 
 
-    static Tensor<double> readmat(int k, FILE* file) {
+    static Tensor<double> readmat(int k, DataTableReader& reader) {
         Tensor<double> a(k,k);
         for (int i=0; i<k; ++i) {
             for (int j=0; j<k; ++j) {
                 double c;
-                if (fscanf(file,"%lf",&c) != 1) {
+                if (!reader.read(c)) {
                     cout << "readmat: twoscale missing coeff?\n";
                     throw "readmat";
                 }
@@ -87,22 +88,25 @@ namespace madness {
     }
 
     static bool read_twoscale(int kmax) {
-        unsigned long correct = 6931979l;
-        unsigned long computed = checksum_file(twoscale_filename);
-        MADNESS_CHECK(correct == computed);
-        FILE* file = fopen(twoscale_filename,"r");
-        if (!file) {
-            cout << "twoscale: failed opening file with twoscale coefficients\n";
-            return false;
+        FILE* file = 0;
+        if (twoscale_filename) {
+            unsigned long correct = 6931979l;
+            unsigned long computed = checksum_file(twoscale_filename);
+            MADNESS_CHECK(correct == computed);
+            file = fopen(twoscale_filename,"r");
+            if (!file) {
+                cout << "twoscale: failed opening file with twoscale coefficients\n";
+                return false;
+            }
         }
+        DataTableReader reader(file, coeffs_table, coeffs_table_size);
         for (int k=1; k<kmax+1; ++k) {
             Tensor <double> h0, g0;
             try {
-                h0 = readmat(k,file);
-                g0 = readmat(k,file);
+                h0 = readmat(k,reader);
+                g0 = readmat(k,reader);
             }
             catch (char *e) {
-                fclose(file);
                 return false;
             }
 
@@ -121,7 +125,6 @@ namespace madness {
             cache[k].g0 = g0;
             cache[k].g1 = g1;
         }
-        fclose(file);
 
         loaded = true;
         return true;
@@ -255,6 +258,7 @@ namespace madness {
     }
 
     bool test_autoc() {
+        if (!autocorr_filename) return true; // embedded table is generated from the checked file
         unsigned long correct = 9056188; // 0x638a9b;
         unsigned long computed = checksum_file(autocorr_filename);
         if (correct != computed)
@@ -267,11 +271,15 @@ namespace madness {
     static bool read_data(int k) {
         if (!test_autoc()) return false;
         kread = -1;
-        FILE *file = fopen(autocorr_filename,"r");
-        if (!file) {
-            cout << "autoc: failed opening file with autocorrelation coefficients" << endl;
-            return false;
+        FILE *file = 0;
+        if (autocorr_filename) {
+            file = fopen(autocorr_filename,"r");
+            if (!file) {
+                cout << "autoc: failed opening file with autocorrelation coefficients" << endl;
+                return false;
+            }
         }
+        DataTableReader reader(file, autocorr_table, autocorr_table_size);
 
         _cread = Tensor<double>(k,k,4*k);
 
@@ -279,9 +287,8 @@ namespace madness {
         while (1) {
             long i, j, p;
             double val;
-            if (fscanf(file,"%ld %ld %ld %lf",&i,&j,&p,&val) != 4) {
+            if (!(reader.read(i) && reader.read(j) && reader.read(p) && reader.read(val))) {
                 cout<<"autoc: failed reading file " << endl;
-                fclose(file);
                 return false;
             }
             if (i >= k) break;
@@ -294,29 +301,38 @@ namespace madness {
             _cread(j,i,p+twok) = val*ij;
         }
 
-        fclose(file);
         kread = k;
         return true;
     }
 
     /// Collective routine to load and cache twoscale & autorrelation coefficients
 
-    /// Only process rank 0 will access the files.
+    /// If dir is null the tables compiled into the library are used by every
+    /// process.  Otherwise only process rank 0 will access the files in dir.
     void load_coeffs(World& world, const char* dir) {
         if (!loaded) {
             int ktop = kmax_autoc;   // Plausible maximum value
-            if (world.rank() == 0) {
+            if (!dir) {
+                if (!read_twoscale(kmax))
+                    throw "load_coeffs: failed reading twoscale coeffs";
+
+                if (!read_data(ktop))
+                    throw "load_coeffs: failed reading coeffs";
+
+                return;
+            }
+            else if (world.rank() == 0) {
                 char buf[32768];
                 buf[0] = 0;
                 strcat(buf,dir);
                 strcat(buf,"/");
-                strcat(buf,twoscale_filename);
+                strcat(buf,"coeffs");
                 twoscale_filename = strdup(buf);
 
                 buf[0] = 0;
                 strcat(buf,dir);
                 strcat(buf,"/");
-                strcat(buf,autocorr_filename);
+                strcat(buf,"autocorr");
                 autocorr_filename = strdup(buf);
 
                 if (!read_twoscale(kmax))
@@ -90,6 +90,7 @@
 #include <madness/mra/mra.h>
 #include <madness/tensor/distributed_matrix.h>
 
+#include <algorithm>
 #include <cstdio>
 
 namespace madness {
@@ -242,6 +243,36 @@ std::vector<Function<T, NDIM>> zero_functions_compressed(World& world, int n, bo
   return r;
 }
 
+/// Projects a vector of functors in a single traversal of a shared tree
+
+/// Equivalent to projecting each functor with the settings of factory, but
+/// each box is visited once for all functions.  Once a functor is screened
+/// in a box (FunctionFunctorInterface::screened() over the box corners) it is
+/// no longer evaluated there or below, so that each box only sees the
+/// functors that overlap it.
+/// @param[in] functors the functors to project
+/// @param[in] factory the settings for the projection; its functor is ignored
+template <typename T, std::size_t NDIM>
+std::vector<Function<T, NDIM>> project_functors(
+    World& world, const std::vector<std::shared_ptr<FunctionFunctorInterface<T, NDIM>>>& functors,
+    const FunctionFactory<T, NDIM>& factory, bool fence = true) {
+  PROFILE_BLOCK(Vproject_functors);
+  typedef FunctionImpl<T, NDIM> implT;
+  std::vector<Function<T, NDIM>> r(functors.size());
+  if (functors.empty()) return r;
+
+  std::vector<implT*> v(functors.size());
+  for (std::size_t i = 0; i < functors.size(); ++i) {
+    FunctionFactory<T, NDIM> f(factory);
+    r[i] = Function<T, NDIM>(f.functor(functors[i]).empty().fence(false));
+    v[i] = r[i].get_impl().get();
+  }
+  world.gop.fence();
+
+  v[0]->project_multi(v, fence);
+  return r;
+}
+
 /// symmetric orthonormalization (see e.g. Szabo/Ostlund)
 /// @param[in] the vector to orthonormalize
 /// @param[in] overlap matrix
@@ -601,31 +632,118 @@ inline double conj(float x) { return x; }
 //        }
 //    }; // struct MatrixInnerTask
 
+/// Computes the distributed matrix of inner products A(i,j) = inner(f[i],g[j])
+
+/// The result is never replicated.  Each process accumulates the
+/// contributions of its own boxes into a sparse map and sends them to the
+/// owners of the matrix elements, so memory grows with the number of
+/// overlapping pairs rather than with the square of the number of
+/// functions.  A box contributes to a pair only if both functions have
+/// coefficients there and the product of their norms exceeds \c tol/nbox ,
+/// where \c nbox is the largest number of boxes of any function in \c f
+/// or \c g , whichever is smaller.  Spatially disjoint functions are never
+/// multiplied, and each element differs by at most \c tol from the
+/// unscreened result.
+///
+/// \c sym (Hermitian) is used only if \c f and \c g are the same vector.
 template <typename T, std::size_t NDIM>
 DistributedMatrix<T> matrix_inner(const DistributedMatrixDistribution& d,
                                   const std::vector<Function<T, NDIM>>& f,
                                   const std::vector<Function<T, NDIM>>& g,
-                                  bool sym = false) {
+                                  bool sym = false,
+                                  double tol = 0.0) {
   PROFILE_FUNC;
   DistributedMatrix<T> A(d);
+  World& world = A.get_world();
   const int64_t n = A.coldim();
   const int64_t m = A.rowdim();
   MADNESS_ASSERT(int64_t(f.size()) == n && int64_t(g.size()) == m);
+  sym = sym && (&f == &g);
 
-  // Assume we can always create an ichunk*jchunk matrix locally
-  const int ichunk = 1000;
-  const int jchunk = 1000;  // 1000*1000*8 = 8 MBytes
-  for (int64_t ilo = 0; ilo < n; ilo += ichunk) {
-    int64_t ihi = std::min(ilo + ichunk, n);
-    std::vector<Function<T, NDIM>> ivec(f.begin() + ilo, f.begin() + ihi);
-    for (int64_t jlo = 0; jlo < m; jlo += jchunk) {
-      int64_t jhi = std::min(jlo + jchunk, m);
-      std::vector<Function<T, NDIM>> jvec(g.begin() + jlo, g.begin() + jhi);
-
-      Tensor<T> P = matrix_inner(A.get_world(), ivec, jvec);
-      A.copy_from_replicated_patch(ilo, ihi - 1, jlo, jhi - 1, P);
+  world.gop.fence();
+  compress(world, f);
+  if (&f != &g) compress(world, g);
+
+  std::vector<const FunctionImpl<T, NDIM>*> left(n), right(m);
+  for (int64_t i = 0; i < n; i++) left[i] = f[i].get_impl().get();
+  for (int64_t j = 0; j < m; j++) right[j] = g[j].get_impl().get();
+
+  // A box bounds its contribution to (i,j) by the product of the norms, and
+  // only boxes where both functions have coefficients contribute
+  double boxtol = 0.0;
+  if (tol > 0.0) {
+    std::vector<double> nbox(n + m, 0.0);
+    for (int64_t i = 0; i < n; i++) nbox[i] = left[i]->get_coeffs().size();
+    for (int64_t j = 0; j < m; j++) nbox[n + j] = right[j]->get_coeffs().size();
+    world.gop.sum(nbox.data(), nbox.size());
+    const double nleft = *std::max_element(nbox.begin(), nbox.begin() + n);
+    const double nright = *std::max_element(nbox.begin() + n, nbox.end());
+    boxtol = tol / std::max(1.0, std::min(nleft, nright));
+  }
+
+  ConcurrentHashMap<int64_t, T> local;
+  FunctionImpl<T, NDIM>::inner_local_sparse(left, (&f == &g) ? left : right, sym, boxtol, local);
+
+  // Add local elements directly and queue the others for their owners
+  const ProcessID me = world.rank();
+  const int nproc = world.size();
+  int64_t ilo, ihi, jlo, jhi;
+  A.local_colrange(ilo, ihi);
+  A.local_rowrange(jlo, jhi);
+  std::vector<std::vector<int64_t>> sendidx(nproc);
+  std::vector<std::vector<T>> sendval(nproc);
+  auto add = [&](int64_t i, int64_t j, const T value) {
+    const ProcessID p = A.owner(i, j);
+    if (p == me) {
+      A.data()(i - ilo, j - jlo) += value;
+    } else {
+      sendidx[p].push_back(i * m + j);
+      sendval[p].push_back(value);
     }
+  };
+  for (typename ConcurrentHashMap<int64_t, T>::iterator it = local.begin(); it != local.end(); ++it) {
+    const int64_t i = it->first / m, j = it->first % m;
+    add(i, j, it->second);
+    if (sym && i != j) add(j, i, conj(it->second));
+  }
+  local.clear();
+
+  // Exchange the counts, then the elements
+  const int tag = world.mpi.comm().unique_tag();
+  std::vector<int64_t> nsend(nproc), nrecv(nproc, 0);
+  std::vector<SafeMPI::Request> req;
+  for (ProcessID p = 0; p < nproc; p++) {
+    if (p == me) continue;
+    nsend[p] = sendidx[p].size();
+    req.push_back(world.mpi.Isend(nsend[p], p, tag));
+    req.push_back(world.mpi.Irecv(nrecv[p], p, tag));
   }
+  for (SafeMPI::Request& r : req) world.await(r, false);
+  req.clear();
+
+  std::vector<std::vector<int64_t>> recvidx(nproc);
+  std::vector<std::vector<T>> recvval(nproc);
+  for (ProcessID p = 0; p < nproc; p++) {
+    if (nsend[p] > 0 && p != me) {
+      req.push_back(world.mpi.Isend(sendidx[p].data(), nsend[p] * sizeof(int64_t), MPI_BYTE, p, tag));
+      req.push_back(world.mpi.Isend(sendval[p].data(), nsend[p] * sizeof(T), MPI_BYTE, p, tag));
+    }
+    if (nrecv[p] > 0) {
+      recvidx[p].resize(nrecv[p]);
+      recvval[p].resize(nrecv[p]);
+      req.push_back(world.mpi.Irecv(recvidx[p].data(), nrecv[p], p, tag));
+      req.push_back(world.mpi.Irecv(recvval[p].data(), nrecv[p], p, tag));
+    }
+  }
+  for (SafeMPI::Request& r : req) world.await(r, false);
+
+  for (ProcessID p = 0; p < nproc; p++) {
+    for (int64_t k = 0; k < nrecv[p]; k++) {
+      const int64_t i = recvidx[p][k] / m, j = recvidx[p][k] % m;
+      A.data()(i - ilo, j - jlo) += recvval[p][k];
+    }
+  }
+  world.gop.fence();
   return A;
 }
 
@@ -806,6 +924,36 @@ void norm_tree(World& world, const std::vector<Function<T, NDIM>>& v, bool fence
   if (fence) world.gop.fence();
 }
 
+/// Upper bounds for the overlaps \int |a_i| |b_j| from box norms at a coarse level
+
+/// Uses Cauchy-Schwarz in each box of the given level, i.e. the result bounds
+/// the 1-norm of the products a_i*b_j, which allows to skip negligible products
+/// before forming them. Functions must be reconstructed with norm_tree()
+/// computed. The default level gives 4096 boxes.
+/// @return     tensor of size (a.size(), b.size())
+template <typename T, typename R, std::size_t NDIM>
+Tensor<double> overlap_bounds(World& world,
+                              const std::vector<Function<T, NDIM>>& a,
+                              const std::vector<Function<R, NDIM>>& b,
+                              int level = -1) {
+  PROFILE_BLOCK(Voverlap_bounds);
+  if (level < 0) level = 12 / NDIM;
+  const long nbox = 1l << (level * NDIM);
+
+  Tensor<double> anorms(a.size(), nbox), bnorms(b.size(), nbox);
+  for (unsigned int i = 0; i < a.size(); ++i) {
+    Tensor<double> row = anorms(i, _);
+    a[i].get_impl()->local_box_norms(level, row);
+  }
+  for (unsigned int i = 0; i < b.size(); ++i) {
+    Tensor<double> row = bnorms(i, _);
+    b[i].get_impl()->local_box_norms(level, row);
+  }
+  world.gop.sum(anorms.ptr(), anorms.size());
+  world.gop.sum(bnorms.ptr(), bnorms.size());
+  return inner(anorms, bnorms, 1, 1);
+}
+
 /// Multiplies two vectors of functions q[i] = a[i] * b[i]
 template <typename T, typename R, std::size_t NDIM>
 std::vector<Function<TENSOR_RESULT_TYPE(T, R), NDIM>> mul(World& world,
@@ -1334,10 +1482,8 @@ std::vector<Function<T, NDIM>> grad(const Function<T, NDIM>& f, bool refine = fa
 
   std::vector<std::shared_ptr<Derivative<T, NDIM>>> grad = gradient_operator<T, NDIM>(world);
 
-  std::vector<Function<T, NDIM>> result(NDIM);
-  for (size_t i = 0; i < NDIM; ++i) result[i] = apply(*(grad[i]), f, false);
-  if (fence) world.gop.fence();
-  return result;
+  // fencing inside apply lets it gather the neighbors into a ghost layer
+  return apply(grad, f, fence);
 }
 
 // BLM first derivative
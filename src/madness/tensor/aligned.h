@@ -46,6 +46,8 @@
 #include <madness/tensor/cblas.h>
 #include <cstring>
 #include <climits>
+#include <cmath>
+#include <complex>
 
 namespace madness {
 
@@ -143,6 +145,123 @@ namespace madness {
         }
         for (long i=0; i<rem; ++i) *a++ -= *b++;
     }
+
+    /* The kernels below are the contiguous fast paths of the elementwise
+     * Tensor operations.  The loops are simple enough for the compiler to
+     * vectorize; the reductions keep eight partial sums so that the additions
+     * are not serialized on one register, which changes the order of the
+     * summation but not its accuracy. */
+
+    /// Returns x*y+z, fused into one rounding where the hardware has FMA
+    template <typename T>
+    static inline T aligned_madd(T x, T y, T z) {
+        return x*y + z;
+    }
+
+#ifdef FP_FAST_FMA
+    template <>
+    inline double aligned_madd(double x, double y, double z) {
+        return std::fma(x, y, z);
+    }
+#endif
+
+    /// Returns the square of the modulus, \c x*x for real and \c std::norm for complex
+    template <typename T>
+    static inline T aligned_abs2(T x) {
+        return x*x;
+    }
+
+    template <typename T>
+    static inline T aligned_abs2(std::complex<T> x) {
+        return std::norm(x);
+    }
+
+    /// a = a*s
+    template <typename T, typename Q>
+    static
+    inline
+    void aligned_scale(long n, T* MADNESS_RESTRICT a, Q s) {
+        for (long i=0; i<n; ++i) a[i] *= s;
+    }
+
+    /// a = a*b (elementwise)
+    template <typename T, typename Q>
+    static
+    inline
+    void aligned_emul(long n, T* MADNESS_RESTRICT a, const Q* MADNESS_RESTRICT b) {
+        for (long i=0; i<n; ++i) a[i] *= b[i];
+    }
+
+    /// a = alpha*a + beta*b
+    template <typename T>
+    static
+    inline
+    void aligned_gaxpy(long n, T* MADNESS_RESTRICT a, T alpha, const T* MADNESS_RESTRICT b, T beta) {
+        if (alpha == T(1.0)) {
+            for (long i=0; i<n; ++i) a[i] = aligned_madd(beta, b[i], a[i]);
+        }
+        else {
+            for (long i=0; i<n; ++i) a[i] = aligned_madd(beta, b[i], alpha*a[i]);
+        }
+    }
+
+    /// a = alpha*a + beta*b*c (elementwise) in one pass
+    template <typename T>
+    static
+    inline
+    void aligned_gaxpy_emul(long n, T* MADNESS_RESTRICT a, T alpha, T beta,
+                            const T* MADNESS_RESTRICT b, const T* MADNESS_RESTRICT c) {
+        if (alpha == T(1.0)) {
+            for (long i=0; i<n; ++i) a[i] = aligned_madd(beta*b[i], c[i], a[i]);
+        }
+        else {
+            for (long i=0; i<n; ++i) a[i] = aligned_madd(beta*b[i], c[i], alpha*a[i]);
+        }
+    }
+
+    /// Returns the sum of |a[i]|^2 accumulated in R
+    template <typename R, typename T>
+    static
+    inline
+    R aligned_sumsq(long n, const T* MADNESS_RESTRICT a) {
+        R s0=0, s1=0, s2=0, s3=0, s4=0, s5=0, s6=0, s7=0;
+        long n8 = (n>>3)<<3;
+        long rem = n-n8;
+        for (long i=0; i<n8; i+=8,a+=8) {
+            s0 += aligned_abs2(a[0]);
+            s1 += aligned_abs2(a[1]);
+            s2 += aligned_abs2(a[2]);
+            s3 += aligned_abs2(a[3]);
+            s4 += aligned_abs2(a[4]);
+            s5 += aligned_abs2(a[5]);
+            s6 += aligned_abs2(a[6]);
+            s7 += aligned_abs2(a[7]);
+        }
+        for (long i=0; i<rem; ++i) s0 += aligned_abs2(*a++);
+        return ((s0+s1)+(s2+s3)) + ((s4+s5)+(s6+s7));
+    }
+
+    /// Returns the sum of a[i]*b[i] (no complex conjugate)
+    template <typename T>
+    static
+    inline
+    T aligned_dot(long n, const T* MADNESS_RESTRICT a, const T* MADNESS_RESTRICT b) {
+        T s0=0, s1=0, s2=0, s3=0, s4=0, s5=0, s6=0, s7=0;
+        long n8 = (n>>3)<<3;
+        long rem = n-n8;
+        for (long i=0; i<n8; i+=8,a+=8,b+=8) {
+            s0 = aligned_madd(a[0], b[0], s0);
+            s1 = aligned_madd(a[1], b[1], s1);
+            s2 = aligned_madd(a[2], b[2], s2);
+            s3 = aligned_madd(a[3], b[3], s3);
+            s4 = aligned_madd(a[4], b[4], s4);
+            s5 = aligned_madd(a[5], b[5], s5);
+            s6 = aligned_madd(a[6], b[6], s6);
+            s7 = aligned_madd(a[7], b[7], s7);
+        }
+        for (long i=0; i<rem; ++i) s0 += (*a++) * (*b++);
+        return ((s0+s1)+(s2+s3)) + ((s4+s5)+(s6+s7));
+    }
 }
 
 #endif // MADNESS_TENSOR_ALIGNED_H__INCLUDED
@@ -199,6 +199,7 @@ namespace madness {
 		size_t real_size() const {return this->size();}
 
         void reduce_rank(const double& eps) {return;};
+        void orthonormalize(const double& eps) {return;};
         void normalize() {return;}
 
         std::string what_am_i() const {return "GenTensor, aliased to Tensor";};
@@ -54,6 +54,8 @@ using madness::Tensor;
 
 #include <madness/tensor/tensor_lapack.h>
 #include <madness/tensor/clapack.h>
+#include <madness/world/MADworld.h>
+#include <madness/world/timers.h>
 #ifdef MADNESS_LINALG_USE_LAPACKE
 using madness::lapacke::to_cptr;
 using madness::lapacke::to_zptr;
@@ -1238,6 +1240,205 @@ namespace madness {
     }
 
 
+    /// make t a contiguous (d0,d1) matrix, reusing its memory if possible
+    template <typename T>
+    STATIC void batched_output(Tensor<T>& t, long d0, long d1) {
+        if (t.ndim()==2 and t.dim(0)==d0 and t.dim(1)==d1 and t.iscontiguous()) return;
+        t=Tensor<T>(d0,d1);
+    }
+
+    /// make t a contiguous vector of length d0, reusing its memory if possible
+    template <typename T>
+    STATIC void batched_output(Tensor<T>& t, long d0) {
+        if (t.ndim()==1 and t.dim(0)==d0 and t.iscontiguous()) return;
+        t=Tensor<T>(d0);
+    }
+
+    /// Batched singular value decomposition of matrices of the same shape
+
+    /// Does svd(a[i],U[i],s[i],VT[i]) for i in [begin,end); the workspace and
+    /// the scratch copy of the input are allocated once for the batch
+    template <typename T>
+    void svd_batched(const std::vector< Tensor<T> >& a, std::vector< Tensor<T> >& U,
+                     std::vector< Tensor< typename Tensor<T>::scalar_type > >& s,
+                     std::vector< Tensor<T> >& VT, long begin, long end) {
+        if (end<0) end=a.size();
+        if (begin>=end) return;
+        if (U.size()<a.size()) U.resize(a.size());
+        if (s.size()<a.size()) s.resize(a.size());
+        if (VT.size()<a.size()) VT.resize(a.size());
+
+        TENSOR_ASSERT(a[begin].ndim() == 2, "svd_batched requires matrices",a[begin].ndim(),&a[begin]);
+        integer m = a[begin].dim(0), n = a[begin].dim(1), rmax = min<integer>(m,n);
+        integer lwork = max<integer>(3*min(m,n)+max(m,n),5*min(m,n)-4)*32;
+        integer info;
+        Tensor<T> A(m,n), work(lwork);
+
+        for (long i=begin; i<end; ++i) {
+            TENSOR_ASSERT(a[i].ndim()==2 and a[i].dim(0)==m and a[i].dim(1)==n,
+                          "svd_batched requires matrices of the same shape",i,&a[i]);
+            A(_,_)=a[i];   // gesvd destroys its input
+            batched_output(s[i],rmax);
+            batched_output(U[i],m,rmax);
+            batched_output(VT[i],rmax,n);
+            dgesvd_("S","S", &n, &m, A.ptr(), &n, s[i].ptr(),
+                    VT[i].ptr(), &n, U[i].ptr(), &rmax, work.ptr(), &lwork,
+                    &info, (char_len) 1, (char_len) 1);
+            mask_info(info);
+            TENSOR_ASSERT(info == 0, "svd_batched: Lapack failed", info, &a[i]);
+        }
+    }
+
+    /// Batched eigendecomposition of symmetric or Hermitian matrices of the same size
+
+    /// Does syev(A[i],V[i],e[i]) for i in [begin,end); the workspace is
+    /// allocated once for the batch and the transpositions are done in place
+    template <typename T>
+    void syev_batched(const std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& V,
+                      std::vector< Tensor< typename Tensor<T>::scalar_type > >& e,
+                      long begin, long end) {
+        if (end<0) end=A.size();
+        if (begin>=end) return;
+        if (V.size()<A.size()) V.resize(A.size());
+        if (e.size()<A.size()) e.resize(A.size());
+
+        TENSOR_ASSERT(A[begin].ndim() == 2, "syev_batched requires matrices",A[begin].ndim(),&A[begin]);
+        integer n = A[begin].dim(0);
+        integer lwork = max(max((integer) 1,(integer) (3*n-1)),(integer) (34*n));
+        integer info;
+        Tensor<T> work(lwork);
+
+        for (long i=begin; i<end; ++i) {
+            TENSOR_ASSERT(A[i].ndim()==2 and A[i].dim(0)==n and A[i].dim(1)==n,
+                          "syev_batched requires square matrices of the same size",i,&A[i]);
+            batched_output(V[i],n,n);
+            batched_output(e[i],n);
+            T* MADNESS_RESTRICT v=V[i].ptr();
+            for (long j=0; j<n; ++j)
+                for (long k=0; k<n; ++k) v[j*n+k]=A[i](k,j);   // For Hermitian case
+            dsyev_("V", "U", &n, v, &n, e[i].ptr(), work.ptr(), &lwork, &info,
+                   (char_len) 1, (char_len) 1);
+            mask_info(info);
+            TENSOR_ASSERT(info == 0, "syev_batched: (s/d)syev/(c/z)heev failed", info, &A[i]);
+            for (long j=0; j<n; ++j)
+                for (long k=j+1; k<n; ++k) std::swap(v[j*n+k],v[k*n+j]);
+        }
+    }
+
+    /// Batched QR decomposition of matrices of the same shape
+
+    /// Does qr(A[i],R[i]) for i in [begin,end); the workspace, tau and the
+    /// scratch for the transposed matrix are allocated once for the batch
+    template <typename T>
+    void qr_batched(std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& R,
+                    long begin, long end) {
+        if (end<0) end=A.size();
+        if (begin>=end) return;
+        if (R.size()<A.size()) R.resize(A.size());
+
+        TENSOR_ASSERT(A[begin].ndim() == 2, "qr_batched requires matrices",A[begin].ndim(),&A[begin]);
+        integer m=A[begin].dim(0);
+        integer n=A[begin].dim(1);
+        integer r_rows=std::min(m,n);
+        Tensor<T> tau(r_rows);
+        integer lwork=2*n+(n+1)*64;
+        Tensor<T> work(lwork);
+        Tensor<T> scratch(n*m);
+
+        for (long i=begin; i<end; ++i) {
+            TENSOR_ASSERT(A[i].ndim()==2 and A[i].dim(0)==m and A[i].dim(1)==n,
+                          "qr_batched requires matrices of the same shape",i,&A[i]);
+            Tensor<T> At=scratch.reshape(n,m);
+            T* MADNESS_RESTRICT at=At.ptr();
+            for (long j=0; j<n; ++j)
+                for (long k=0; k<m; ++k) at[j*m+k]=A[i](k,j);
+
+            batched_output(R[i],r_rows,n);
+            R[i]=0.0;
+            lq_result(At,R[i],tau,work,true);
+
+            // At is now the (r_rows,m) matrix Q^T
+            batched_output(A[i],m,r_rows);
+            T* MADNESS_RESTRICT q=A[i].ptr();
+            for (long j=0; j<m; ++j)
+                for (long k=0; k<r_rows; ++k) q[j*r_rows+k]=At(k,j);
+        }
+    }
+
+    /// run the batched decomposition op on [begin,end); returns true when done
+    template <typename opT>
+    STATIC bool batched_chunk(const opT* op, long begin, long end) {
+        (*op)(begin,end);
+        return true;
+    }
+
+    /// split [0,n) into chunks and run op on them as tasks, one per thread
+    template <typename opT>
+    STATIC void batched_for_each(World& world, long n, const opT& op) {
+        const long nchunk=std::min<long>(n,ThreadPool::size()+1);
+        if (nchunk<=1) {
+            op(0,n);
+            return;
+        }
+        std::vector< Future<bool> > done(nchunk);
+        for (long c=0; c<nchunk; ++c) {
+            done[c]=world.taskq.add(batched_chunk<opT>,&op,c*n/nchunk,(c+1)*n/nchunk);
+        }
+        for (long c=0; c<nchunk; ++c) done[c].get();
+    }
+
+    template <typename T>
+    struct svd_batched_op {
+        const std::vector< Tensor<T> >* a;
+        std::vector< Tensor<T> >* U;
+        std::vector< Tensor< typename Tensor<T>::scalar_type > >* s;
+        std::vector< Tensor<T> >* VT;
+        void operator()(long begin, long end) const {svd_batched(*a,*U,*s,*VT,begin,end);}
+    };
+
+    template <typename T>
+    struct syev_batched_op {
+        const std::vector< Tensor<T> >* A;
+        std::vector< Tensor<T> >* V;
+        std::vector< Tensor< typename Tensor<T>::scalar_type > >* e;
+        void operator()(long begin, long end) const {syev_batched(*A,*V,*e,begin,end);}
+    };
+
+    template <typename T>
+    struct qr_batched_op {
+        std::vector< Tensor<T> >* A;
+        std::vector< Tensor<T> >* R;
+        void operator()(long begin, long end) const {qr_batched(*A,*R,begin,end);}
+    };
+
+    template <typename T>
+    void svd_batched(World& world, const std::vector< Tensor<T> >& a, std::vector< Tensor<T> >& U,
+                     std::vector< Tensor< typename Tensor<T>::scalar_type > >& s,
+                     std::vector< Tensor<T> >& VT) {
+        U.resize(a.size());
+        s.resize(a.size());
+        VT.resize(a.size());
+        svd_batched_op<T> op={&a,&U,&s,&VT};
+        batched_for_each(world,a.size(),op);
+    }
+
+    template <typename T>
+    void syev_batched(World& world, const std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& V,
+                      std::vector< Tensor< typename Tensor<T>::scalar_type > >& e) {
+        V.resize(A.size());
+        e.resize(A.size());
+        syev_batched_op<T> op={&A,&V,&e};
+        batched_for_each(world,A.size(),op);
+    }
+
+    template <typename T>
+    void qr_batched(World& world, std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& R) {
+        R.resize(A.size());
+        qr_batched_op<T> op={&A,&R};
+        batched_for_each(world,A.size(),op);
+    }
+
+
 //     template <typename T>
 //     void triangular_solve(const Tensor<T>& L, Tensor<T>& B, const char* side, const char* transa) {
 //         integer n = L.dim(0);  // ????
@@ -1422,6 +1623,52 @@ namespace madness {
         return (LLT - aa).normf()/n;
     }
 
+    /// Test the batched decompositions against the single calls and time them
+    template <typename T>
+    double test_batched(int nbatch, int n) {
+        typedef typename Tensor<T>::scalar_type scalar_type;
+        std::vector< Tensor<T> > a(nbatch), sym(nbatch), Q(nbatch);
+        for (int i=0; i<nbatch; ++i) {
+            a[i]=Tensor<T>(n,n);
+            a[i].fillrandom();
+            sym[i]=a[i]+madness::my_conj_transpose(a[i]);
+            Q[i]=copy(a[i]);
+        }
+
+        std::vector< Tensor<T> > U, VT, V, R;
+        std::vector< Tensor<scalar_type> > s, e;
+        double t0=cpu_time();
+        svd_batched(a,U,s,VT);
+        syev_batched(sym,V,e);
+        qr_batched(Q,R);
+        double t1=cpu_time();
+
+        std::vector< Tensor<T> > U1(nbatch), VT1(nbatch), V1(nbatch), Q1(nbatch), R1(nbatch);
+        std::vector< Tensor<scalar_type> > s1(nbatch), e1(nbatch);
+        for (int i=0; i<nbatch; ++i) {
+            svd(a[i],U1[i],s1[i],VT1[i]);
+            syev(sym[i],V1[i],e1[i]);
+            Q1[i]=copy(a[i]);
+            qr(Q1[i],R1[i]);
+        }
+        double t2=cpu_time();
+        cout << "batched svd, syev and qr of " << nbatch << " (" << n << "," << n << ") matrices "
+             << t1-t0 << " s, single calls " << t2-t1 << " s" << endl;
+
+        // same lapack calls on the same data
+        double err=0.0;
+        for (int i=0; i<nbatch; ++i) {
+            err=max(err,(double) (U[i]-U1[i]).normf());
+            err=max(err,(double) (s[i]-s1[i]).normf());
+            err=max(err,(double) (VT[i]-VT1[i]).normf());
+            err=max(err,(double) (V[i]-V1[i]).normf());
+            err=max(err,(double) (e[i]-e1[i]).normf());
+            err=max(err,(double) (Q[i]-Q1[i]).normf());
+            err=max(err,(double) (R[i]-R1[i]).normf());
+        }
+        return err;
+    }
+
     template <typename T>
     double test_qr() {
 
@@ -1538,6 +1785,10 @@ namespace madness {
             cout << "error in double inverse " << test_inverse<double>(32) << endl;
             cout << "error in double inverse " << test_inverse<double>(47) << endl;
             cout << endl;
+
+            double err_batched=test_batched<double>(2000,12);  // prints its timings
+            cout << "error in double batched " << err_batched << endl;
+            cout << endl;
         }
 
         catch (TensorException& e) {
@@ -1621,6 +1872,30 @@ namespace madness {
     template
     void orgqr(Tensor<double>& A, const Tensor<double>& tau);
 
+    template
+    void svd_batched(const std::vector< Tensor<double> >& a, std::vector< Tensor<double> >& U,
+                     std::vector< Tensor<double> >& s, std::vector< Tensor<double> >& VT,
+                     long begin, long end);
+
+    template
+    void svd_batched(World& world, const std::vector< Tensor<double> >& a, std::vector< Tensor<double> >& U,
+                     std::vector< Tensor<double> >& s, std::vector< Tensor<double> >& VT);
+
+    template
+    void syev_batched(const std::vector< Tensor<double> >& A, std::vector< Tensor<double> >& V,
+                      std::vector< Tensor<double> >& e, long begin, long end);
+
+    template
+    void syev_batched(World& world, const std::vector< Tensor<double> >& A, std::vector< Tensor<double> >& V,
+                      std::vector< Tensor<double> >& e);
+
+    template
+    void qr_batched(std::vector< Tensor<double> >& A, std::vector< Tensor<double> >& R,
+                    long begin, long end);
+
+    template
+    void qr_batched(World& world, std::vector< Tensor<double> >& A, std::vector< Tensor<double> >& R);
+
 
     template
     void svd_result(Tensor<float_complex>& a, Tensor<float_complex>& U,
@@ -1646,6 +1921,24 @@ namespace madness {
     void syev(const Tensor<double_complex>& A,
               Tensor<double_complex>& V, Tensor<Tensor<double_complex>::scalar_type >& e);
 
+    template
+    void svd_batched(const std::vector< Tensor<double_complex> >& a, std::vector< Tensor<double_complex> >& U,
+                     std::vector< Tensor<double> >& s, std::vector< Tensor<double_complex> >& VT,
+                     long begin, long end);
+
+    template
+    void svd_batched(World& world, const std::vector< Tensor<double_complex> >& a,
+                     std::vector< Tensor<double_complex> >& U,
+                     std::vector< Tensor<double> >& s, std::vector< Tensor<double_complex> >& VT);
+
+    template
+    void syev_batched(const std::vector< Tensor<double_complex> >& A, std::vector< Tensor<double_complex> >& V,
+                      std::vector< Tensor<double> >& e, long begin, long end);
+
+    template
+    void syev_batched(World& world, const std::vector< Tensor<double_complex> >& A,
+                      std::vector< Tensor<double_complex> >& V, std::vector< Tensor<double> >& e);
+
     template
     void cholesky(Tensor<double_complex>& A);
 
@@ -631,6 +631,20 @@ public:
         }
     }
 
+    /// reduce the rank in a single pass
+
+    /// unlike reduce_rank this does not divide the configurations into
+    /// chunks, so it is the method of choice for tensors that have been
+    /// appended to many times without rank reduction
+    void orthonormalize(const double& thresh) {
+        if ((type==TT_FULL) or (type==TT_NONE)) return;
+        else if (type==TT_2D) impl.svd->orthonormalize(thresh*facReduce());
+        else if (type==TT_TENSORTRAIN) impl.tt->truncate(thresh*facReduce());
+        else {
+            MADNESS_EXCEPTION("you should not be here",1);
+        }
+    }
+
     /// Returns a pointer to the internal data
 
     /// @param[in]  ivec    index of core vector to which the return values points
@@ -179,7 +179,49 @@ namespace madness {
             }
         }
     }
-    
+
+    /// Matrix = Matrix transpose * matrix ... square matrix of fixed size
+
+    /// Does \c C=AT*B with \c b a dense \c K*K matrix, i.e. \c dimj=dimk=K .
+    /// \code
+    ///    c(i,j) = sum(k) a(k,i)*b(k,j)  <------ does not accumulate into C
+    /// \endcode
+    ///
+    /// With the inner dimensions known at compile time the k loop is fully
+    /// unrolled and the j loop vectorized.  Four rows of \c c are computed
+    /// together so that each row of \c b is loaded once per four rows.  Used
+    /// by fast_transform for the common values of k.
+    template <long K, typename aT, typename bT, typename cT>
+    void mTxmq_fixed(long dimi, cT* MADNESS_RESTRICT c, const aT* MADNESS_RESTRICT a,
+                     const bT* MADNESS_RESTRICT b) {
+        long i=0;
+        for (; i+4<=dimi; i+=4, c+=4*K) {
+            for (long j=0; j<4*K; ++j) c[j] = 0.0;
+            // unrolled, since GCC's vectorized k loop reads past the end of a
+#pragma GCC unroll 16
+            for (long k=0; k<K; ++k) {
+                const aT* aki = a+k*dimi+i;
+                const bT* MADNESS_RESTRICT bk = b+k*K;
+                const aT a0=aki[0], a1=aki[1], a2=aki[2], a3=aki[3];
+                for (long j=0; j<K; ++j) {
+                    c[j    ] += a0*bk[j];
+                    c[j+  K] += a1*bk[j];
+                    c[j+2*K] += a2*bk[j];
+                    c[j+3*K] += a3*bk[j];
+                }
+            }
+        }
+        for (; i<dimi; ++i, c+=K) {
+            for (long j=0; j<K; ++j) c[j] = 0.0;
+#pragma GCC unroll 16
+            for (long k=0; k<K; ++k) {
+                const aT aki = a[k*dimi+i];
+                const bT* MADNESS_RESTRICT bk = b+k*K;
+                for (long j=0; j<K; ++j) c[j] += aki*bk[j];
+            }
+        }
+    }
+
 
 #if defined(HAVE_FAST_BLAS) && !defined(HAVE_INTEL_MKL)
     // MKL provides support for mixed real/complex operations but most other libraries do not
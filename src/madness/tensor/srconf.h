@@ -541,7 +541,7 @@ namespace madness {
             if (check_orthonormality) rhs.check_right_orthonormality();
 
             this->undo_structure();
-            ortho5(ref_vector(0),ref_vector(1),weights_,
+            ortho_update(ref_vector(0),ref_vector(1),weights_,
 					rhs.flat_vector(0),rhs.flat_vector(1),rhs.weights_,thresh);
 			rank_=weights_.size();
 			make_structure();
@@ -1672,6 +1672,139 @@ protected:
 		return;
 	}
 
+	/// incremental version of ortho5
+
+	/// adds two bi-orthonormal configs like ortho5, but as an update of the
+	/// SVD of the first one: only the parts of x2 and y2 outside the spans of
+	/// x1 and y1 are orthonormalized, which reveals the rank of the update
+	/// with eigenproblems of size rank2 instead of rank1+rank2.  Residual
+	/// directions are screened as in ortho5, and the SVD is of the small
+	/// core matrix only.  The result will be written onto the first config.
+	/// operation count is O(k(r1+r2)r + r2^3 + (r1+q)^3), q being the rank
+	/// of the residual
+	///
+	/// @param[in,out]	x1	left subspace, will hold the result on exit
+	/// @param[in,out]	y1	right subspace, will hold the result on exit
+	/// @param[in]		x2	left subspace, will be accumulated onto x1
+	/// @param[in]		y2	right subspace, will be accumulated onto y1
+	template<typename T>
+	void ortho_update(Tensor<T>& x1, Tensor<T>& y1, Tensor<double>& w1,
+				const Tensor<T>& x2, const Tensor<T>& y2, const Tensor<double>& w2,
+				const double& thresh) {
+
+#ifdef BENCH
+		double cpu0=wall_time();
+#endif
+		typedef Tensor<T> tensorT;
+
+		const long rank1=x1.dim(0);
+		const long rank2=x2.dim(0);
+
+		const double w_max=std::max(w1.absmax(),w2.absmax());
+		const double norm_max=w_max*(rank1+rank2);		// max Frobenius norm
+
+		// projection of 2 onto 1; the residual of 2 is R = x2 - Px x1
+		const tensorT Px=inner(x2,x1,1,1);
+		const tensorT Py=inner(y2,y1,1,1);
+
+		// orthonormalize the residuals through their overlap 1 - P P^T
+		//   Q = C R,  C = e^(-1/2) U^T   and   R = B Q,  B = U e^(1/2)
+		// screening small eigenvalues reveals the rank of the residual
+		auto residual = [&](const tensorT& P, tensorT& B, tensorT& C) {
+			tensorT S=inner(P,P,1,1);
+			S.scale(-1.0);
+			for (long i=0; i<rank2; ++i) S(i,i)+=1.0;
+			tensorT U;
+			Tensor<double> e;
+			syev(S,U,e);
+			long lo=0;
+			while (lo<rank2 and e(lo)<thresh/norm_max) ++lo;
+			const long q=rank2-lo;
+			B=tensorT(rank2,q);
+			C=tensorT(q,rank2);
+			for (long j=0; j<q; ++j) {
+				const double sqrt_e=sqrt(e(lo+j));
+				for (long i=0; i<rank2; ++i) {
+					B(i,j)=U(i,lo+j)*sqrt_e;
+					C(j,i)=U(i,lo+j)/sqrt_e;
+				}
+			}
+		};
+		tensorT Bx, Cx, By, Cy;
+		residual(Px,Bx,Cx);
+		residual(Py,By,Cy);
+		const long qx=Cx.dim(0);
+		const long qy=Cy.dim(0);
+#ifdef BENCH
+		double cpu1=wall_time();
+		SRConf<T>::time(27)+=cpu1-cpu0;
+#endif
+
+		// core matrix in the basis [x1; Qx] x [y1; Qy]:
+		//   K = w1 (+) 0 + [Px Bx]^T w2 [Py By]
+		tensorT Gx(rank2,rank1+qx), Gy(rank2,rank1+qy);
+		Gx(_,Slice(0,rank1-1))=Px;
+		Gy(_,Slice(0,rank1-1))=Py;
+		if (qx>0) Gx(_,Slice(rank1,-1))=Bx;
+		if (qy>0) Gy(_,Slice(rank1,-1))=By;
+		for (long i=0; i<rank2; ++i) Gx(i,_)*=w2(i);
+		tensorT K=inner(Gx,Gy,0,0);
+		for (long i=0; i<rank1; ++i) K(i,i)+=w1(i);
+
+		// decompose K
+		tensorT Up,VTp;
+		Tensor<double> Sp;
+		svd(K,Up,Sp,VTp);
+#ifdef BENCH
+		double cpu2=wall_time();
+		SRConf<T>::time(28)+=cpu2-cpu1;
+#endif
+
+		// find the maximal singular value that's supposed to contribute
+		// singular values are ordered (largest first)
+		double residual_norm=0.0;
+		long i;
+		for (i=Sp.dim(0)-1; i>=0; i--) {
+			residual_norm+=Sp(i)*Sp(i);
+			if (residual_norm>thresh*thresh) break;
+		}
+
+		// convert SVD output to our convention
+		if (i>=0) {
+
+			// [x1; Qx] = [x1; Cx (x2 - Px x1)], so that the new vectors are
+			// Ua^T x1 + Ub^T Cx (x2 - Px x1)
+			const Slice s0(0,rank1-1), sr(0,i);
+			tensorT X1=transpose(Up(s0,sr));
+			tensorT Y1=copy(VTp(sr,s0));
+			tensorT X2(i+1,rank2), Y2(i+1,rank2);
+			if (qx>0) {
+				X2=inner(Up(Slice(rank1,-1),sr),Cx,0,0);
+				X1-=inner(X2,Px,1,0);
+			}
+			if (qy>0) {
+				Y2=inner(VTp(sr,Slice(rank1,-1)),Cy,1,0);
+				Y1-=inner(Y2,Py,1,0);
+			}
+
+			x1=inner(X1,x1,1,0);
+			y1=inner(Y1,y1,1,0);
+			if (qx>0) inner_result(X2,x2,1,0,x1);
+			if (qy>0) inner_result(Y2,y2,1,0,y1);
+			w1=Sp(Slice(0,i));
+
+		} else {
+			x1.clear();
+			y1.clear();
+			w1.clear();
+		}
+#ifdef BENCH
+		double cpu3=wall_time();
+		SRConf<T>::time(29)+=cpu3-cpu2;
+		SRConf<T>::time(26)+=cpu3-cpu0;
+#endif
+	}
+
 	template<typename T>
 	static inline
 	std::ostream& operator<<(std::ostream& s, const SRConf<T>& sr) {
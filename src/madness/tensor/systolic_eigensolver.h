@@ -0,0 +1,253 @@
+#ifndef MADNESS_SYSTOLIC_EIGENSOLVER_H
+#define MADNESS_SYSTOLIC_EIGENSOLVER_H
+
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/// \file systolic_eigensolver.h
+/// \brief Distributed symmetric eigensolver using one-sided Jacobi on the systolic loop
+
+#include <madness/world/MADworld.h>
+#include <madness/world/atomicint.h>
+#include <madness/tensor/tensor.h>
+#include <madness/tensor/distributed_matrix.h>
+#include <madness/tensor/systolic.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace madness {
+
+    /// One-sided Jacobi eigensolver for a real symmetric matrix
+
+    /// Row \c i of the column-distributed matrix \c AV holds the
+    /// concatenation <tt>[A v_i | v_i]</tt>, initially the \c i'th row
+    /// of \c A and of the identity.  Each pair of rows generated by the
+    /// systolic loop is rotated so that <tt>v_i^T A v_j = 0</tt>, which
+    /// keeps the left half equal to \c A times the right half.  Sweeps
+    /// are repeated until no off-diagonal element exceeds \c thresh , after
+    /// which <tt>v_i^T A v_i</tt> are the eigenvalues and \c v_i the
+    /// eigenvectors.  Since only pairs of rows are touched no process ever
+    /// holds more than its own rows.
+    template <typename T>
+    class SystolicEigensolver : public SystolicMatrixAlgorithm<T> {
+        static_assert(std::is_floating_point<T>::value, "SystolicEigensolver is only for real matrices");
+
+        const int64_t n;        ///< Dimension of the eigenproblem
+        const T thresh;         ///< Off-diagonal elements smaller than this are not rotated
+        const int maxsweep;     ///< Maximum number of sweeps
+        int& nsweep;            ///< No. of sweeps on convergence, -1 if not converged
+        int niter;              ///< No. of sweeps done so far
+        AtomicInt nrot;         ///< No. of rotations in the current sweep
+        bool done;              ///< Set at the end of the sweep that converged
+
+    public:
+        /// AV must be column distributed with dimension \c (n,2n)
+
+        /// @param[in,out] AV The concatenated matrix <tt>[A | I]</tt>, on return <tt>[A V^T | V^T]</tt>
+        /// @param[in] thresh Off-diagonal elements smaller than this are not rotated
+        /// @param[in] maxsweep Maximum number of sweeps
+        /// @param[out] nsweep No. of sweeps on return, or -1 if not converged in \c maxsweep sweeps
+        /// @param[in] tag The MPI tag used for communication
+        /// @param[in] nthread The number of local threads to use
+        SystolicEigensolver(DistributedMatrix<T>& AV, T thresh, int maxsweep, int& nsweep, int tag,
+                            int nthread=ThreadPool::size()+1)
+            : SystolicMatrixAlgorithm<T>(AV, tag, nthread)
+            , n(AV.coldim())
+            , thresh(thresh)
+            , maxsweep(maxsweep)
+            , nsweep(nsweep)
+            , niter(0)
+            , done(false)
+        {
+            MADNESS_ASSERT(AV.is_column_distributed() && AV.rowdim() == 2*n);
+            nrot = 0;
+            nsweep = -1;
+        }
+
+        virtual ~SystolicEigensolver() {}
+
+        void start_iteration_hook(const TaskThreadEnv& env) {
+            if (env.id() == 0) nrot = 0;
+        }
+
+        void kernel(int i, int j, T* rowi, T* rowj) {
+            T* MADNESS_RESTRICT ai = rowi;
+            T* MADNESS_RESTRICT aj = rowj;
+            T* MADNESS_RESTRICT vi = rowi + n;
+            T* MADNESS_RESTRICT vj = rowj + n;
+
+            // (2x2) block of V^T A V in one pass over the rows
+            T aii = 0, ajj = 0, aij = 0;
+            for (int64_t k=0; k<n; ++k) {
+                aii += vi[k]*ai[k];
+                ajj += vj[k]*aj[k];
+                aij += vi[k]*aj[k];
+            }
+            if (!(std::abs(aij) > thresh)) return;
+            nrot++;
+
+            // Smaller root of t^2 + 2 theta t - 1 = 0 as in the serial Jacobi method
+            const T theta = (ajj - aii)/(2*aij);
+            T t;
+            if (std::abs(theta) > T(1.e50)) t = T(0.5)/theta;
+            else t = std::copysign(T(1),theta)/(std::abs(theta) + std::sqrt(theta*theta + 1));
+            const T c = 1/std::sqrt(t*t + 1);
+            const T s = t*c;
+
+            for (int64_t k=0; k<n; ++k) {
+                const T a = ai[k], b = aj[k];
+                ai[k] = c*a - s*b;
+                aj[k] = s*a + c*b;
+            }
+            for (int64_t k=0; k<n; ++k) {
+                const T a = vi[k], b = vj[k];
+                vi[k] = c*a - s*b;
+                vj[k] = s*a + c*b;
+            }
+        }
+
+        void end_iteration_hook(const TaskThreadEnv& env) {
+            if (env.id() == 0) {
+                int64_t nrotsum = nrot;
+                this->get_world().gop.sum(nrotsum);
+                ++niter;
+                if (nrotsum == 0) nsweep = niter;
+                done = (nrotsum == 0 || niter >= maxsweep);
+            }
+        }
+
+        bool converged(const TaskThreadEnv& env) const {
+            return done;
+        }
+    };
+
+
+    /// Eigenvalues and eigenvectors of a real symmetric column-distributed matrix (collective call)
+
+    /// Solves <tt>A v = e v</tt> with the parallel one-sided Jacobi method
+    /// of SystolicEigensolver, so the work and memory are spread over the
+    /// processes holding rows of \c A and the matrix is never replicated.
+    ///
+    /// The eigenvalues are returned replicated in ascending order.
+    /// Since the rows stay distributed, the eigenvectors are returned as
+    /// the \em rows of \c V (i.e., \c V is the transpose of what the
+    /// serial \c syev returns): row \c i of \c V is the eigenvector of \c e(i) .
+    /// \c V has the same column distribution as \c A .
+    ///
+    /// Off-diagonal elements are annihilated until they are below
+    /// <tt>tol*||A||_F</tt>, so the accuracy is that of the serial solver
+    /// up to a factor of \c tol/epsilon .  The default tolerance is just
+    /// above the rounding error in the length \c n inner products.
+    /// @param[in] A The symmetric (n,n) matrix, column distributed, unchanged on return
+    /// @param[out] V The (n,n) matrix of eigenvectors stored by rows
+    /// @param[out] e The eigenvalues in ascending order
+    /// @param[in] tol Relative threshold for the off-diagonal elements (default chosen from \c n)
+    /// @param[in] maxsweep Maximum number of Jacobi sweeps before throwing
+    template <typename T>
+    void syev(const DistributedMatrix<T>& A, DistributedMatrix<T>& V, Tensor<T>& e,
+              T tol=0, int maxsweep=50) {
+        MADNESS_CHECK(A.is_column_distributed() && A.coldim() == A.rowdim());
+        World& world = A.get_world();
+        const int64_t n = A.coldim();
+        int64_t ilo, ihi;
+        A.local_colrange(ilo, ihi);
+
+        if (tol <= 0) tol = 10*std::sqrt(T(n))*std::numeric_limits<T>::epsilon();
+        T normsq = A.local_size() > 0 ? A.data().normf() : T(0);
+        normsq *= normsq;
+        world.gop.sum(normsq);
+
+        DistributedMatrix<T> I = column_distributed_matrix<T>(world, n, n, A.coltile());
+        I.fill_identity();
+        DistributedMatrix<T> AV = concatenate_rows(A, I);
+
+        // Threads spin at a barrier after each step of the loop, so each should update
+        // at least about 128K elements per step (each local pair updates 4n elements)
+        const int64_t work = std::max(ihi-ilo+1, int64_t(0))*2*n;
+        const int nthread = std::max(1, std::min(int(ThreadPool::size())+1, int(work >> 17)));
+
+        int nsweep;
+        world.taskq.add(new SystolicEigensolver<T>(AV, tol*std::sqrt(normsq), maxsweep, nsweep,
+                                                   world.mpi.comm().unique_tag(), nthread));
+        world.taskq.fence();
+        if (nsweep < 0) MADNESS_EXCEPTION("syev: Jacobi sweeps did not converge", maxsweep);
+
+        // Eigenvalues from the converged rows
+        e = Tensor<T>(n);
+        const Tensor<T>& av = AV.data();
+        for (int64_t i=ilo; i<=ihi; ++i) {
+            const T* MADNESS_RESTRICT ai = &av(i-ilo,0);
+            const T* MADNESS_RESTRICT vi = ai + n;
+            T sum = 0;
+            for (int64_t k=0; k<n; ++k) sum += vi[k]*ai[k];
+            e(i) = sum;
+        }
+        world.gop.sum(e.ptr(), n);
+
+        // Sort, moving the eigenvectors directly to the process owning their new row
+        std::vector<int64_t> order(n);
+        std::iota(order.begin(), order.end(), int64_t(0));
+        std::stable_sort(order.begin(), order.end(),
+                         [&e](int64_t a, int64_t b) {return e(a) < e(b);});
+
+        V = column_distributed_matrix<T>(world, n, n, A.coltile());
+        Tensor<T>& v = V.data();
+        const ProcessID me = world.rank();
+        const int tag = world.mpi.comm().unique_tag();
+        std::vector<SafeMPI::Request> req;
+
+        // Messages between a pair of processes are matched in order of the new row index
+        for (int64_t i=0; i<n; ++i) {
+            const int64_t k = order[i];
+            const ProcessID src = AV.owner(k,0), dest = V.owner(i,0);
+            if (src == me && dest == me) {
+                std::memcpy(&v(i-ilo,0), &av(k-ilo,n), n*sizeof(T));
+            }
+            else if (src == me) {
+                req.push_back(world.mpi.Isend(&av(k-ilo,n), n*sizeof(T), MPI_BYTE, dest, tag));
+            }
+            else if (dest == me) {
+                req.push_back(world.mpi.Irecv(&v(i-ilo,0), n, src, tag));
+            }
+        }
+        for (SafeMPI::Request& r : req) world.await(r, false);
+
+        Tensor<T> esorted(n);
+        for (int64_t i=0; i<n; ++i) esorted(i) = e(order[i]);
+        e = esorted;
+    }
+}
+
+#endif
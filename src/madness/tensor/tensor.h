@@ -722,7 +722,10 @@ class Tensor : public BaseTensor {
   template <typename Q>
   typename IsSupported<TensorTypeData<Q>, Tensor<T>&>::type operator*=(
       const Q& x) {
-    UNARY_OPTIMIZED_ITERATOR(T, (*this), *_p0 *= x);
+    if (iscontiguous())
+      aligned_scale(_size, ptr(), x);
+    else
+      UNARY_OPTIMIZED_ITERATOR(T, (*this), *_p0 *= x);
     return *this;
   }
 
@@ -1811,6 +1814,7 @@ class Tensor : public BaseTensor {
 
   /// Returns the sum of the squares of the elements
   T sumsq() const {
+    if (iscontiguous()) return aligned_dot(_size, ptr(), ptr());
     T result = 0;
     UNARY_OPTIMIZED_ITERATOR(const T, (*this), result += (*_p0) * (*_p0));
     return result;
@@ -1867,8 +1871,11 @@ class Tensor : public BaseTensor {
   /// Returns the Frobenius norm of the tensor
   float_scalar_type normf() const {
     float_scalar_type result = 0;
-    UNARY_OPTIMIZED_ITERATOR(const T, (*this),
-                             result += ::madness::detail::mynorm(*_p0));
+    if (iscontiguous())
+      result = aligned_sumsq<float_scalar_type>(_size, ptr());
+    else
+      UNARY_OPTIMIZED_ITERATOR(const T, (*this),
+                               result += ::madness::detail::mynorm(*_p0));
     return (float_scalar_type)std::sqrt(result);
   }
 
@@ -1918,6 +1925,8 @@ class Tensor : public BaseTensor {
 
   /// Return the trace of two tensors (no complex conjugate invoked)
   T trace(const Tensor<T>& t) const {
+    if (iscontiguous() && t.iscontiguous() && _size == t.size())
+      return aligned_dot(_size, ptr(), t.ptr());
     T result = 0;
     BINARY_OPTIMIZED_ITERATOR(const T, (*this), const T, t,
                               result += (*_p0) * (*_p1));
@@ -1944,20 +1953,17 @@ class Tensor : public BaseTensor {
 
   /// Inplace multiply by corresponding elements of argument Tensor
   Tensor<T>& emul(const Tensor<T>& t) {
-    BINARY_OPTIMIZED_ITERATOR(T, (*this), const T, t, *_p0 *= *_p1);
+    if (iscontiguous() && t.iscontiguous() && _size == t.size())
+      aligned_emul(_size, ptr(), t.ptr());
+    else
+      BINARY_OPTIMIZED_ITERATOR(T, (*this), const T, t, *_p0 *= *_p1);
     return *this;
   }
 
   /// Inplace generalized saxpy ... this = this*alpha + other*beta
   Tensor<T>& gaxpy(T alpha, const Tensor<T>& t, T beta) {
     if (iscontiguous() && t.iscontiguous()) {
-      T* MADNESS_RESTRICT a = ptr();
-      const T* MADNESS_RESTRICT b = t.ptr();
-      if (alpha == T(1.0)) {
-        for (long i = 0; i < _size; ++i) a[i] += b[i] * beta;
-      } else {
-        for (long i = 0; i < _size; ++i) a[i] = a[i] * alpha + b[i] * beta;
-      }
+      aligned_gaxpy(_size, ptr(), alpha, t.ptr(), beta);
     } else {
       // BINARYITERATOR(T,(*this),T,t, (*_p0) = alpha*(*_p0) + beta*(*_p1));
       BINARY_OPTIMIZED_ITERATOR(T, (*this), const T, t,
@@ -1967,6 +1973,23 @@ class Tensor : public BaseTensor {
     return *this;
   }
 
+  /// Inplace fused multiply-add ... this = this*alpha + y*z*beta (elementwise)
+
+  /// Evaluated in one pass without the temporaries of
+  /// \c (*this)=alpha*(*this)+beta*copy(y).emul(z) .
+  Tensor<T>& gaxpy_emul(T alpha, T beta, const Tensor<T>& y,
+                        const Tensor<T>& z) {
+    if (iscontiguous() && y.iscontiguous() && z.iscontiguous() &&
+        _size == y.size() && _size == z.size()) {
+      aligned_gaxpy_emul(_size, ptr(), alpha, beta, y.ptr(), z.ptr());
+    } else {
+      TERNARY_OPTIMIZED_ITERATOR(T, (*this), const T, y, const T, z,
+                                 (*_p0) = alpha * (*_p0) +
+                                          beta * (*_p1) * (*_p2));
+    }
+    return *this;
+  }
+
   /// Returns a pointer to the internal data
   T* ptr() { return _p; }
 
@@ -2516,6 +2539,70 @@ Tensor<TENSOR_RESULT_TYPE(T, Q)> transform(const Tensor<T>& t,
   }
 }
 
+namespace detail {
+/// Transform all NDIM dimensions of a contiguous K^NDIM tensor
+
+/// Dimension n is transformed with the dense K*K matrix \c c[n] .  The
+/// intermediate results alternate between \c t0 and \c t1 , starting with
+/// \c t0 ; the result ends in \c t0 for odd NDIM and in \c t1 for even NDIM.
+template <std::size_t NDIM, long K, typename T, typename Q, typename resultT>
+void fixed_transform(const T* t, const Q* const c[], resultT* t0,
+                     resultT* t1) {
+  long dimi = 1;
+  for (std::size_t n = 1; n < NDIM; ++n) dimi *= K;
+  mTxmq_fixed<K>(dimi, t0, t, c[0]);
+  for (std::size_t n = 1; n < NDIM; ++n) {
+    mTxmq_fixed<K>(dimi, t1, t0, c[n]);
+    std::swap(t0, t1);
+  }
+}
+
+/// True if fixed_transform has a kernel for this dimension and k
+
+/// The kernels rely on the compiler to unroll and vectorize them.  They beat
+/// mTxmq with AVX2 and FMA at both -O2 and -O3 only for the multiples of the
+/// vector length and k=6, so only those are instantiated.
+inline bool has_fixed_transform(long ndim, long k) {
+  return (ndim == 3 || ndim == 6) && (k == 6 || k == 8 || k == 12 || k == 16);
+}
+
+/// True if the transforms dispatch to fixed_transform
+
+/// Without AVX2/FMA the kernels are slower for some k, and in an
+/// unoptimized build mTxmq is much faster.
+inline bool use_fixed_transform(long ndim, long k) {
+#if defined(__OPTIMIZE__) && defined(__AVX2__) && defined(__FMA__)
+  return has_fixed_transform(ndim, k);
+#else
+  (void)ndim;
+  (void)k;
+  return false;
+#endif
+}
+
+template <long K, typename T, typename Q, typename resultT>
+void fixed_transform(long ndim, const T* t, const Q* const c[], resultT* t0,
+                     resultT* t1) {
+  if (ndim == 3)
+    fixed_transform<3, K>(t, c, t0, t1);
+  else
+    fixed_transform<6, K>(t, c, t0, t1);
+}
+
+/// Runtime dispatch to the compile-time kernels, see has_fixed_transform
+template <typename T, typename Q, typename resultT>
+void fixed_transform(long ndim, long k, const T* t, const Q* const c[],
+                     resultT* t0, resultT* t1) {
+  MADNESS_ASSERT(has_fixed_transform(ndim, k));
+  switch (k) {
+    case 6: fixed_transform<6>(ndim, t, c, t0, t1); break;
+    case 8: fixed_transform<8>(ndim, t, c, t0, t1); break;
+    case 12: fixed_transform<12>(ndim, t, c, t0, t1); break;
+    default: fixed_transform<16>(ndim, t, c, t0, t1); break;
+  }
+}
+}  // namespace detail
+
 /// Transform all dimensions of the tensor t by distinct matrices c
 
 /// \ingroup tensor
@@ -2529,6 +2616,24 @@ template <class T, class Q>
 Tensor<TENSOR_RESULT_TYPE(T, Q)> general_transform(const Tensor<T>& t,
                                                    const Tensor<Q> c[]) {
   typedef TENSOR_RESULT_TYPE(T, Q) resultT;
+  if (t.iscontiguous() && t.ndim() > 0) {
+    const long k = t.dim(0);
+    bool square = true;
+    const Q* pc[TENSOR_MAXDIM];
+    for (long i = 0; i < t.ndim(); ++i) {
+      square = square && t.dim(i) == k && c[i].ndim() == 2 &&
+               c[i].dim(0) == k && c[i].dim(1) == k && c[i].iscontiguous();
+      pc[i] = c[i].ptr();
+    }
+    if (square && detail::use_fixed_transform(t.ndim(), k)) {
+      Tensor<resultT> result(t.ndim(), t.dims(), false);
+      Tensor<resultT> work(t.ndim(), t.dims(), false);
+      resultT *t0 = work.ptr(), *t1 = result.ptr();
+      if (t.ndim() & 1) std::swap(t0, t1);
+      detail::fixed_transform(t.ndim(), k, t.ptr(), pc, t0, t1);
+      return result;
+    }
+  }
   Tensor<resultT> result = t;
   for (long i = 0; i < t.ndim(); ++i) {
     result = inner(result, c[i], 0, 0);
@@ -2564,7 +2669,10 @@ Tensor<TENSOR_RESULT_TYPE(T, Q)> general_transform(const Tensor<T>& t,
 ///     c(j',j) c(k',k) ...
 /// \endcode
 ///
-/// The input dimensions of \c t must all be the same .
+/// The input dimensions of \c t must all be the same .  For NDIM 3 and 6
+/// and k in 6, 8, 12 and 16 an optimized build with AVX2 and FMA uses a
+/// kernel with the dimensions fixed at compile time (see
+/// detail::use_fixed_transform and test_fast_transform).
 template <class T, class Q>
 Tensor<TENSOR_RESULT_TYPE(T, Q)>& fast_transform(
     const Tensor<T>& t, const Tensor<Q>& c,
@@ -2600,6 +2708,13 @@ Tensor<TENSOR_RESULT_TYPE(T, Q)>& fast_transform(
     }
   }
 #else
+  if (c.dim(0) == dimj && detail::use_fixed_transform(t.ndim(), dimj)) {
+    const Q* cs[TENSOR_MAXDIM];
+    for (int n = 0; n < t.ndim(); ++n) cs[n] = pc;
+    detail::fixed_transform(t.ndim(), dimj, t.ptr(), cs, t0, t1);
+    return result;
+  }
+
   // Now assume no restriction on the use of mtxmq
   mTxmq(dimi, dimj, dimj, t0, t.ptr(), pc);
   for (int n = 1; n < t.ndim(); ++n) {
@@ -167,6 +167,53 @@ void lq_result(Tensor<T>& A, Tensor<T>& R, Tensor<T>& tau, Tensor<T>& work,
 template <typename T>
 void geqp3(Tensor<T>& A, Tensor<T>& tau, Tensor<integer>& jpvt);
 
+/// Batched SVD of matrices of the same shape
+
+/// \ingroup linalg
+/// Same as svd for a[i], i in [begin,end), with end<0 meaning all, but the
+/// workspace is allocated once for the batch and outputs of the right shape
+/// are overwritten in place.  Meant for many small problems, e.g. the rank
+/// reductions of the nodes of a tree.
+template <typename T>
+void svd_batched(const std::vector<Tensor<T> >& a, std::vector<Tensor<T> >& U,
+                 std::vector<Tensor<typename Tensor<T>::scalar_type> >& s,
+                 std::vector<Tensor<T> >& VT, long begin = 0, long end = -1);
+
+/// Batched SVD, split between the threads of the pool, each with its own workspace
+template <typename T>
+void svd_batched(World& world, const std::vector<Tensor<T> >& a,
+                 std::vector<Tensor<T> >& U,
+                 std::vector<Tensor<typename Tensor<T>::scalar_type> >& s,
+                 std::vector<Tensor<T> >& VT);
+
+/// Batched symmetric or Hermitian eigenproblem of matrices of the same size
+
+/// \ingroup linalg
+/// Same as syev for A[i], i in [begin,end), see svd_batched
+template <typename T>
+void syev_batched(const std::vector<Tensor<T> >& A, std::vector<Tensor<T> >& V,
+                  std::vector<Tensor<typename Tensor<T>::scalar_type> >& e,
+                  long begin = 0, long end = -1);
+
+/// Batched eigenproblem, split between the threads of the pool
+template <typename T>
+void syev_batched(World& world, const std::vector<Tensor<T> >& A,
+                  std::vector<Tensor<T> >& V,
+                  std::vector<Tensor<typename Tensor<T>::scalar_type> >& e);
+
+/// Batched QR decomposition of matrices of the same shape
+
+/// \ingroup linalg
+/// Same as qr for A[i], i in [begin,end), see svd_batched; real only
+template <typename T>
+void qr_batched(std::vector<Tensor<T> >& A, std::vector<Tensor<T> >& R,
+                long begin = 0, long end = -1);
+
+/// Batched QR decomposition, split between the threads of the pool
+template <typename T>
+void qr_batched(World& world, std::vector<Tensor<T> >& A,
+                std::vector<Tensor<T> >& R);
+
 /// orgqr generates an M-by-N complex matrix Q with orthonormal columns
 
 /// which is defined as the first N columns of a product of K elementary
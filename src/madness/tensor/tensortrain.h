@@ -811,14 +811,39 @@ namespace madness {
 				}
 			}
 
-			Tensor<T> result=core.front();
-			typename std::vector<Tensor<T> >::const_iterator it;
-
-			for (it=++core.begin(); it!=core.end(); ++it) {
-				result=inner(result,*it);
-				if (flat) result=result.fusedim(0);
+			if (core.size()==1) return flat ? core.front().flat() : core.front();
+
+			// contract the cores from left to right, alternating between two
+			// scratch buffers; the last contraction writes into the result
+			const long nd=core.size();
+			std::vector<long> d;
+			long maxsize=0;
+			for (long i=0, m=1; i<nd; ++i) {
+				const long first= (i==0) ? 0 : 1;
+				const long last= (i==nd-1) ? core[i].ndim() : core[i].ndim()-1;
+				for (long j=first; j<last; ++j) {
+					d.push_back(core[i].dim(j));
+					m*=core[i].dim(j);
+				}
+				if (i<nd-1) maxsize=std::max(maxsize,m*core[i].dim(last));
 			}
-			return result;
+			Tensor<T> result(d);
+			Tensor<T> buffer(std::vector<long>(1,2*maxsize),false);
+
+			const Tensor<T> c0= core[0].iscontiguous() ? core[0] : madness::copy(core[0]);
+			const T* left=c0.ptr();
+			long m=c0.size()/c0.dim(c0.ndim()-1);
+			for (long i=1; i<nd; ++i) {
+				const Tensor<T> c= core[i].iscontiguous() ? core[i] : madness::copy(core[i]);
+				const long r=c.dim(0);
+				const long n=c.size()/r;
+				T* out= (i==nd-1) ? result.ptr() : buffer.ptr()+(i%2)*maxsize;
+				if (i<nd-1) std::fill(out,out+m*n,T(0));
+				mxm(m,n,r,out,left,c.ptr());
+				left=out;
+				if (i<nd-1) m*=n/c.dim(c.ndim()-1);
+			}
+			return flat ? result.flat() : result;
 		}
 
 		/// construct a two-mode representation (aka unnormalized SVD)
@@ -962,10 +987,8 @@ namespace madness {
 		            L = 0.0;
 		        }
 
-		        // workaround for LQ decomposition to avoid reallocations
-		        //L_buffer = 0.0;
-		        lq_tau = 0.0;
-		        lq_work = 0.0;
+		        // workaround for LQ decomposition to avoid reallocations;
+		        // tau and the workspace are overwritten by lapack
 		        lq_result(core[d],L,lq_tau,lq_work,false);
 		        // slice L to the right size
 		        //Tensor<T> L = L_buffer(Slice(0,r0-1),Slice(0,r1-1));
@@ -1001,7 +1024,6 @@ namespace madness {
 
 		        Tensor<T> U,VT;
 		        long ds=std::min(core[d].dim(0),core[d].dim(1));
-		        s_buffer = 0.0;
 		        //Tensor< typename Tensor<T>::scalar_type > s(ds)
 		        Tensor< typename Tensor<T>::scalar_type > s = s_buffer(Slice(0,ds-1));
 
@@ -1010,8 +1032,7 @@ namespace madness {
 		        // get the dimensions of U and V
 		        long du = core[d].dim(0);
 		        long dv = core[d].dim(1);
-		        U_buffer = 0.0;
-		        svd_buffer = 0.0;
+		        // U, s and the workspace are overwritten by lapack
 		        U_buffer = U_buffer.flat();
 		        // VT is written on core[d] input
 		        svd_result(core[d],U_buffer,s,dummy,svd_buffer);
@@ -1030,10 +1051,10 @@ namespace madness {
 		        dimensions[ndim-1]=r_truncate;
 		        core[d]=U.reshape(ndim,dimensions);
 
-		        for (int i=0; i<VT.dim(0); ++i) {
-		            for (int j=0; j<VT.dim(1); ++j) {
-		                VT(i,j)*=s(i);
-		            }
+		        T* MADNESS_RESTRICT vt=VT.ptr();
+		        for (long i=0; i<r_truncate; ++i) {
+		            const T si=s(i);
+		            for (long j=0; j<dv; ++j) vt[i*dv+j]*=si;
 		        }
 
 		        // multiply to the right (line 11)
@@ -1318,6 +1339,29 @@ namespace madness {
 	};
 
 
+    /// transform the middle index of a TT core with the matrix c
+
+    /// result(r1,j,r2) = sum(i) core(r1,i,r2) c(i,j)
+    /// one mTxmq per left rank index on the contiguous core storage, without
+    /// scratch tensors or transposition of the result
+    template <class T, class Q>
+    Tensor<TENSOR_RESULT_TYPE(T,Q)> transform_tt_core(const Tensor<T>& core,
+            const Tensor<Q>& c) {
+
+        typedef TENSOR_RESULT_TYPE(T,Q) resultT;
+        MADNESS_ASSERT(core.ndim()==3 and c.ndim()==2 and core.dim(1)==c.dim(0));
+
+        const Tensor<T> g= core.iscontiguous() ? core : copy(core);
+        const Tensor<Q> cc= c.iscontiguous() ? c : copy(c);
+        const long r1=g.dim(0), i=g.dim(1), r2=g.dim(2), j=cc.dim(1);
+
+        Tensor<resultT> result(std::vector<long>{r1,j,r2},false);
+        for (long a=0; a<r1; ++a) {
+            mTxmq(j,r2,i,result.ptr()+a*j*r2,cc.ptr(),g.ptr()+a*i*r2);
+        }
+        return result;
+    }
+
 	/// transform each dimension with the same operator matrix
 
     /// result(i,j,k...) <-- sum(i',j', k',...) t(i',j',k',...) c(i',i) c(j',j) c(k',k) ...
@@ -1341,22 +1385,7 @@ namespace madness {
         if (ndim>1) result.core[ndim-1]=inner(t.core[ndim-1],c,1,0);
 
         // other cores have dimensions core(r1,i2,r2);
-
-        // set up scratch tensor
-        long size=0;
-        for (int d=1; d<ndim-1; ++d) size=std::max(size,t.core[d].size());
-        Tensor<resultT> tmp(size);
-
-        for (int d=1; d<ndim-1; ++d) {
-            long r1=t.core[d].dim(0);
-            long i2=t.core[d].dim(1);
-            long r2=t.core[d].dim(2);
-
-            // zero out old stuff from the scratch tensor
-            if (d>1) tmp(Slice(0,r1*i2*r2-1))=0.0;
-            inner_result(t.core[d],c,1,0,tmp);
-            result.core[d]=copy(tmp(Slice(0,r1*i2*r2-1)).reshape(r1,r2,i2).swapdim(1,2));
-        }
+        for (int d=1; d<ndim-1; ++d) result.core[d]=transform_tt_core(t.core[d],c);
         return result;
     }
 
@@ -1390,22 +1419,7 @@ namespace madness {
         if (ndim>1) result.core[ndim-1]=inner(t.core[ndim-1],c[ndim-1],1,0);
 
         // other cores have dimensions core(r1,i2,r2);
-
-        // set up scratch tensor
-        long size=0;
-        for (int d=1; d<ndim-1; ++d) size=std::max(size,t.core[d].size());
-        Tensor<resultT> tmp(size);
-
-        for (int d=1; d<ndim-1; ++d) {
-            long r1=t.core[d].dim(0);
-            long i2=t.core[d].dim(1);
-            long r2=t.core[d].dim(2);
-
-            // zero out old stuff from the scratch tensor
-            if (d>1) tmp(Slice(0,r1*i2*r2-1))=0.0;
-            inner_result(t.core[d],c[d],1,0,tmp);
-            result.core[d]=copy(tmp(Slice(0,r1*i2*r2-1)).reshape(r1,r2,i2).swapdim(1,2));
-        }
+        for (int d=1; d<ndim-1; ++d) result.core[d]=transform_tt_core(t.core[d],c[d]);
         return result;
     }
 
@@ -1439,8 +1453,7 @@ namespace madness {
         } else if (axis==ndim-1) {
             result.core[ndim-1]=inner(t.core[ndim-1],c,1,0);
         } else {
-            Tensor<resultT> tmp=inner(t.core[axis],c,1,0);  // G~(r1,r2,i')
-            result.core[axis]=copy(tmp.swapdim(1,2));
+            result.core[axis]=transform_tt_core(t.core[axis],c);
         }
         return result;
 
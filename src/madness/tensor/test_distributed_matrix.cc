@@ -3,6 +3,9 @@
 #include <madness/madness_config.h>
 #include <madness/world/MADworld.h>
 #include <madness/tensor/distributed_matrix.h>
+#include <madness/tensor/systolic_eigensolver.h>
+#include <cmath>
+#include <cstdlib>
 
 using namespace madness;
 
@@ -33,6 +36,43 @@ void check(DistributedMatrix<double>& A) {
     }
 }
 
+double symm(int64_t i, int64_t j) {
+    return std::sin(1.0 + i + j + 0.1*i*j) + ((i==j) ? 0.01*i : 0.0);
+}
+
+/// Solves the distributed eigenproblem, checks the residual and orthonormality, and returns the wall time
+double check_syev(World& world, int64_t n) {
+    DistributedMatrix<double> A = column_distributed_matrix<double>(world, n, n);
+    A.fill(symm);
+    DistributedMatrix<double> V;
+    Tensor<double> e;
+
+    world.gop.fence();
+    double used = wall_time();
+    syev(A, V, e);
+    used = wall_time() - used;
+
+    // Replicate only to check the result
+    Tensor<double> a(n,n), v(n,n);
+    A.copy_to_replicated(a);
+    V.copy_to_replicated(v);
+
+    Tensor<double> r = inner(v,a);
+    for (int64_t k=0; k<n; k++) r(k,_).gaxpy(1.0, v(k,_), -e(k));
+    const double resid = r.normf()/a.normf();
+
+    Tensor<double> s = inner(v,v,1,1);
+    for (int64_t k=0; k<n; k++) s(k,k) -= 1.0;
+    const double orth = s.normf();
+
+    for (int64_t k=1; k<n; k++) MADNESS_CHECK(e(k-1) <= e(k));
+    if (resid > 1e-13*n || orth > 1e-13*n) {
+        print("syev failed", n, resid, orth);
+        MADNESS_CHECK(false);
+    }
+    return used;
+}
+
 int main(int argc, char** argv) {
     initialize(argc, argv);
     World world(SafeMPI::COMM_WORLD);
@@ -48,6 +88,16 @@ int main(int argc, char** argv) {
         check(A);
     }
 
+    for (int64_t n : {1, 2, 3, 5, 17, 64}) check_syev(world, n);
+
+    // Scaling of the eigensolver with the matrix size (time per sweep grows as n^3)
+    const int64_t nmax = getenv("MAD_SMALL_TESTS") ? 128 : 256;
+    if (world.rank() == 0) print("syev: nproc", world.size(), "nthread", ThreadPool::size()+1);
+    for (int64_t n=32; n<=nmax; n*=2) {
+        double used = check_syev(world, n);
+        if (world.rank() == 0) printf("syev: n=%5ld %8.3fs\n", long(n), used);
+    }
+
     world.gop.fence();
     finalize();
     return 0;
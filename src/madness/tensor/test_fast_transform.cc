@@ -0,0 +1,241 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/// \file test_fast_transform.cc
+/// \brief tests and times the compile-time kernels of fast_transform
+
+/// For each k and NDIM covered by detail::fixed_transform the results of
+/// the kernel, fast_transform and general_transform are compared with the
+/// transform done by inner, then the kernel is timed against the same
+/// transform done by mTxmq with runtime dimensions.  The kernel is also run
+/// on input that ends at a protected page to catch reads past its end.
+/// Run with --small (or MAD_SMALL_TESTS set) to skip the timings.
+
+#include <madness/madness_config.h>
+
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#include <madness/tensor/mxm.h>
+#include <madness/tensor/tensor.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace madness;
+
+typedef std::complex<double> double_complex;
+
+bool smalltest = false;
+
+double ran() {
+    static unsigned long seed = 76521;
+    seed = seed*1812433253 + 12345;
+    return ((double) (seed & 0x7fffffff)) * 4.6566128752458e-10;
+}
+
+template <typename T>
+void ran_fill(Tensor<T>& t) {
+    T* p = t.ptr();
+    for (long i=0; i<t.size(); ++i) p[i] = ran();
+}
+
+template <>
+void ran_fill(Tensor<double_complex>& t) {
+    double_complex* p = t.ptr();
+    for (long i=0; i<t.size(); ++i) p[i] = double_complex(ran(),ran());
+}
+
+double wall() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// the transform by inner, as done by general_transform for other dimensions
+template <typename T, typename Q>
+Tensor<TENSOR_RESULT_TYPE(T,Q)> reference_transform(const Tensor<T>& t, const Tensor<Q> c[]) {
+    Tensor<TENSOR_RESULT_TYPE(T,Q)> result = t;
+    for (long n=0; n<t.ndim(); ++n) result = inner(result, c[n], 0, 0);
+    return result;
+}
+
+/// the transform with runtime dimensions as done before the fixed kernels
+void mtxmq_transform(const Tensor<double>& t, const Tensor<double>& c,
+                     Tensor<double>& result, Tensor<double>& work) {
+    const long k = t.dim(0);
+    long dimi = 1;
+    for (int n=1; n<t.ndim(); ++n) dimi *= k;
+    double *t0 = work.ptr(), *t1 = result.ptr();
+    if (t.ndim() & 1) std::swap(t0, t1);
+    mTxmq(dimi, k, k, t0, t.ptr(), c.ptr());
+    for (int n=1; n<t.ndim(); ++n) {
+        mTxmq(dimi, k, k, t1, t0, c.ptr());
+        std::swap(t0, t1);
+    }
+}
+
+/// compare fast_transform and general_transform with the reference
+template <typename T, typename Q>
+bool test(long ndim, long k) {
+    typedef TENSOR_RESULT_TYPE(T,Q) resultT;
+    std::vector<long> dims(ndim, k);
+    Tensor<T> t(dims);
+    ran_fill(t);
+    Tensor<Q> c[TENSOR_MAXDIM];
+    for (long n=0; n<ndim; ++n) {
+        c[n] = Tensor<Q>(k,k);
+        ran_fill(c[n]);
+    }
+    const double norm = t.normf() * std::pow(c[0].normf(), ndim);
+
+    const Tensor<resultT> ref = reference_transform(t, c);
+    double err = (general_transform(t, c) - ref).normf() / norm;
+
+    if (detail::has_fixed_transform(ndim, k)) {
+        // the kernel itself, also where the transforms do not dispatch to it
+        const Q* pc[TENSOR_MAXDIM];
+        for (long n=0; n<ndim; ++n) pc[n] = c[n].ptr();
+        Tensor<resultT> t0(dims), t1(dims);
+        detail::fixed_transform(ndim, k, t.ptr(), pc, t0.ptr(), t1.ptr());
+        err = std::max(err, (((ndim & 1) ? t0 : t1) - ref).normf() / norm);
+    }
+
+    if constexpr (std::is_same<T,Q>::value) {
+        // fast_transform takes a single matrix of the same type
+        Tensor<Q> csame[TENSOR_MAXDIM];
+        for (long n=0; n<ndim; ++n) csame[n] = c[0];
+        Tensor<resultT> result(dims), work(dims);
+        fast_transform(t, c[0], result, work);
+        err = std::max(err, (result - reference_transform(t, csame)).normf() / norm);
+    }
+
+    bool ok = err < 1.e-14;
+    if (!ok) printf("test_fast_transform: ndim %ld k %2ld error %.1e\n", ndim, k, err);
+    return ok;
+}
+
+/// run mTxmq_fixed with \c a ending right before a protected page
+
+/// A read past the end of \c a faults instead of going unnoticed, see the
+/// notes on the vectorization of mTxmq_fixed.
+template <long K, typename T>
+bool test_overread(long dimi) {
+    const long n = dimi*K;
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const size_t nbyte = ((n*sizeof(T) + page - 1)/page + 1)*page;
+    char* buf = (char*) mmap(nullptr, nbyte, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) return true;
+    mprotect(buf + nbyte - page, page, PROT_NONE);
+    T* a = (T*) (buf + nbyte - page - n*sizeof(T));
+    for (long i=0; i<n; ++i) a[i] = ran();
+
+    std::vector<double> b(K*K);
+    for (double& x : b) x = ran();
+    std::vector<T> c(n), ref(n, T(0.0));
+    mTxmq_fixed<K>(dimi, c.data(), a, b.data());
+    for (long i=0; i<dimi; ++i)
+        for (long k=0; k<K; ++k)
+            for (long j=0; j<K; ++j) ref[i*K+j] += a[k*dimi+i]*b[k*K+j];
+
+    double err = 0.0;
+    for (long i=0; i<n; ++i) err = std::max(err, std::abs(c[i]-ref[i]));
+    munmap(buf, nbyte);
+    bool ok = err < 1.e-12;
+    if (!ok) printf("test_overread: K %ld dimi %ld error %.1e\n", K, dimi, err);
+    return ok;
+}
+
+/// time the kernel against the runtime-dimension transform
+void timer(long ndim, long k) {
+    std::vector<long> dims(ndim, k);
+    Tensor<double> t(dims), result(dims), work(dims), c(k,k);
+    ran_fill(t);
+    ran_fill(c);
+
+    const double* pc[TENSOR_MAXDIM];
+    for (long n=0; n<ndim; ++n) pc[n] = c.ptr();
+
+    const double nflop = 2.0 * ndim * t.size() * k;
+    const long nloop = std::max(1L, long(2.e8/nflop));
+    double fastest = 0.0, fastest_ref = 0.0;
+    for (int rep=0; rep<5; ++rep) {
+        double start = wall();
+        for (long loop=0; loop<nloop; ++loop)
+            detail::fixed_transform(ndim, k, t.ptr(), pc, work.ptr(), result.ptr());
+        fastest = std::max(fastest, 1.e-9*nflop*nloop/(wall()-start));
+
+        start = wall();
+        for (long loop=0; loop<nloop; ++loop) mtxmq_transform(t, c, result, work);
+        fastest_ref = std::max(fastest_ref, 1.e-9*nflop*nloop/(wall()-start));
+    }
+    printf("%6ld %4ld %10.2f %10.2f %8.2f\n", ndim, k, fastest, fastest_ref, fastest/fastest_ref);
+}
+
+int main(int argc, char* argv[]) {
+    if (getenv("MAD_SMALL_TESTS")) smalltest=true;
+    for (int iarg=1; iarg<argc; iarg++) if (strcmp(argv[iarg],"--small")==0) smalltest=true;
+    printf("small test : %d\n", smalltest);
+
+    const long ks[] = {6, 8, 12, 16};
+
+    printf("Starting to test ... \n");
+    bool ok = true;
+    for (long k : ks) {
+        ok = test<double,double>(3, k) && ok;
+        ok = test<double_complex,double>(3, k) && ok;
+        ok = test<double_complex,double_complex>(3, k) && ok;
+        ok = test<double,double_complex>(3, k) && ok;
+        if (k <= 8 || !smalltest) ok = test<double,double>(6, k) && ok;
+    }
+    // dimensions without a fixed kernel take the generic path
+    ok = test<double,double>(3, 7) && ok;
+    ok = test<double,double>(3, 10) && ok;
+    ok = test<double,double>(4, 6) && ok;
+    for (long dimi : {1, 3, 5, 8, 64}) {
+        ok = test_overread<6,double>(dimi) && ok;
+        ok = test_overread<8,double>(dimi) && ok;
+        ok = test_overread<8,double_complex>(dimi) && ok;
+        ok = test_overread<16,double>(dimi) && ok;
+    }
+    if (!ok) return 1;
+    printf("... OK!\n");
+
+    if (!smalltest) {
+        printf("%6s %4s %10s %10s %8s (GF/s)\n", "ndim", "k", "FIXED", "MTXMQ", "SPEEDUP");
+        for (long ndim : {3, 6})
+            for (long k : ks) timer(ndim, k);
+    }
+    return 0;
+}
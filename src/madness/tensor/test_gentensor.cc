@@ -36,6 +36,7 @@
 #include <madness/tensor/gentensor.h>
 #include <madness/tensor/lowranktensor.h>
 #include <madness/world/print.h>
+#include <madness/world/timers.h>
 
 #if defined USE_GENTENSOR && MADNESS_HAS_GOOGLE_TEST
 
@@ -364,6 +365,28 @@ namespace {
     	}
     }
 
+    // checks for many additions without rank reduction, reduced in one pass
+    TEST_P(BinaryGenTest, LazyAccumulation) {
+    	try {
+    		LowRankTensor<double> buffer=copy(g0);
+    		for (int i=0; i<5; ++i) {
+    			t0+=t1;
+    			buffer+=g1;
+    		}
+    		const long rank=buffer.rank();
+    		buffer.orthonormalize(eps);
+    		ASSERT_LT((buffer.full_tensor_copy()-t0).normf(),eps);
+    		ASSERT_LE(buffer.rank(),rank);
+
+    	} catch (const madness::TensorException& e) {
+    		if (dim.size() != 0) std::cout << e;
+    		EXPECT_EQ(dim.size(),0);
+    	} catch(...) {
+    		std::cout << "Caught unknown exception" << std::endl;
+    		EXPECT_EQ(1,0);
+    	}
+    }
+
     // checks for addition with slices
     TEST_P(BinaryGenTest, SliceAddition) {
         Tensor<double> t0_save=copy(t0);
@@ -650,6 +673,68 @@ namespace {
         }
     }
 
+
+    /// random orthonormal configurations
+    Tensor<double> random_orthonormal(long rank, long n) {
+        Tensor<double> a(rank,n), U, s, VT;
+        a.fillrandom();
+        svd(a,U,s,VT);
+        return copy(VT(Slice(0,rank-1),_));
+    }
+
+    /// sum_r x(r,i) w(r) y(r,j)
+    Tensor<double> reconstruct(const Tensor<double>& x, const Tensor<double>& y,
+            const Tensor<double>& w) {
+        Tensor<double> xw=copy(x);
+        for (long r=0; r<x.dim(0); ++r) xw(r,_)*=w(r);
+        return inner(xw,y,0,0);
+    }
+
+    /// the incremental SVD update in SRConf::add_SVD against ortho5, with timings
+    TEST(SRConfTest, IncrementalUpdate) {
+        const long n=1000;      // k^3 for k=10
+        const double thresh=1.e-4;
+        const int nrep=10;
+        for (long rank1 : {20, 60}) {
+            for (long rank2 : {5, 20, 60}) {
+                for (int inspan=0; inspan<2; ++inspan) {
+                    Tensor<double> x1=random_orthonormal(rank1,n), y1=random_orthonormal(rank1,n);
+                    Tensor<double> x2=random_orthonormal(rank2,n), y2=random_orthonormal(rank2,n);
+                    Tensor<double> w1(rank1), w2(rank2);
+                    for (long r=0; r<rank1; ++r) w1(r)=exp(-0.5*r);
+                    for (long r=0; r<rank2; ++r) w2(r)=0.5*exp(-0.5*r);
+
+                    // typical for accumulation: the update lies in the span of the node
+                    if (inspan and rank2<=rank1) {
+                        Tensor<double> o=random_orthonormal(rank2,rank1);
+                        x2=inner(o,x1,1,0);
+                        y2=inner(o,y1,1,0);
+                    }
+                    const Tensor<double> ref=reconstruct(x1,y1,w1)+reconstruct(x2,y2,w2);
+
+                    Tensor<double> xa, ya, wa, xb, yb, wb;
+                    double cpu0=wall_time();
+                    for (int i=0; i<nrep; ++i) {
+                        xa=copy(x1); ya=copy(y1); wa=copy(w1);
+                        ortho5(xa,ya,wa,x2,y2,w2,thresh);
+                    }
+                    double cpu1=wall_time();
+                    for (int i=0; i<nrep; ++i) {
+                        xb=copy(x1); yb=copy(y1); wb=copy(w1);
+                        ortho_update(xb,yb,wb,x2,y2,w2,thresh);
+                    }
+                    double cpu2=wall_time();
+
+                    print("ranks",rank1,rank2,"in span",inspan,"ortho5",(cpu1-cpu0)/nrep,
+                            "ortho_update",(cpu2-cpu1)/nrep);
+                    ASSERT_EQ(wa.size(),wb.size());
+                    ASSERT_LT((reconstruct(xb,yb,wb)-ref).normf(),thresh);
+                    ASSERT_LT((inner(xb,xb,1,1)-inner(xa,xa,1,1)).normf(),1.e-10);
+                }
+            }
+        }
+    }
+
 }
 
 int main(int argc, char** argv) {
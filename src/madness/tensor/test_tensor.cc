@@ -33,6 +33,7 @@
 /// \brief New test code for Tensor class using Google unit test
 
 #include <madness/tensor/tensor.h>
+#include <madness/tensor/vmath.h>
 #include <madness/world/print.h>
 
 #ifdef MADNESS_HAS_GOOGLE_TEST
@@ -415,6 +416,76 @@ namespace {
         ITERATOR3(b,ASSERT_EQ(b(_i,_j,_k), a(_j,_i,_k)));
     }
 
+    TYPED_TEST(TensorTest, Elementwise) {
+        // the contiguous kernels (aligned.h) against the strided iterators
+        for (long n=1; n<=21; n+=4) {
+            madness::Tensor<TypeParam> a(n,n+3), b(n,n+3), c(n,n+3);
+            a.fillindex(); b.fillindex(); c.fill(TypeParam(3));
+            a += TypeParam(1);
+            madness::Tensor<TypeParam> aT = a.swapdim(0,1), bT = b.swapdim(0,1), cT = c.swapdim(0,1);
+            ASSERT_TRUE(a.iscontiguous());
+            ASSERT_FALSE(aT.iscontiguous());
+
+            double normsq = 0.0;
+            TypeParam sumsq = 0, trace = 0;
+            ITERATOR2(a, normsq += std::norm(a(IND2)));
+            ITERATOR2(a, sumsq += a(IND2)*a(IND2));
+            ITERATOR2(a, trace += a(IND2)*b(IND2));
+            ASSERT_TRUE(check(a.normf(), std::sqrt(normsq), 1e-5));
+            ASSERT_TRUE(check(aT.normf(), std::sqrt(normsq), 1e-5));
+            ASSERT_TRUE(check(a.sumsq(), sumsq, 1e-5));
+            ASSERT_TRUE(check(a.trace(b), trace, 1e-5));
+            ASSERT_TRUE(check(aT.trace(bT), trace, 1e-5));
+
+            madness::Tensor<TypeParam> d = copy(a), dT = copy(a);
+            d.gaxpy(TypeParam(2),b,TypeParam(3));
+            dT.swapdim(0,1).gaxpy(TypeParam(2),bT,TypeParam(3));
+            ITERATOR2(d, ASSERT_EQ(d(IND2),TypeParam(2)*a(IND2)+TypeParam(3)*b(IND2)));
+            ITERATOR2(d, ASSERT_EQ(dT(IND2),d(IND2)));
+
+            d = copy(a); dT = copy(a);
+            d.gaxpy_emul(TypeParam(2),TypeParam(1),b,c);
+            dT.swapdim(0,1).gaxpy_emul(TypeParam(2),TypeParam(1),bT,cT);
+            ITERATOR2(d, ASSERT_EQ(d(IND2),TypeParam(2)*a(IND2)+b(IND2)*c(IND2)));
+            ITERATOR2(d, ASSERT_EQ(dT(IND2),d(IND2)));
+
+            d = copy(a); dT = copy(a);
+            d.emul(c);
+            dT.swapdim(0,1).emul(cT);
+            ITERATOR2(d, ASSERT_EQ(d(IND2),a(IND2)*c(IND2)));
+            ITERATOR2(d, ASSERT_EQ(dT(IND2),d(IND2)));
+        }
+    }
+
+    TEST(VMathTest, Accuracy) {
+        // the vector kernels against the C++ library, with arguments that are
+        // passed on to it and an in-place call
+        const long n=2000;
+        std::vector<double> x(n), y(n), s(n), c(n), a(n);
+        std::vector<double_complex> z(n), w(n);
+        for (long i=0; i<n; ++i) {
+            x[i]=(i-n/2)*0.37;
+            z[i]=double_complex(0.1*x[i],(i%7)*x[i]);
+        }
+        x[0]=709.5; x[1]=-740.0; x[2]=2.e5; x[3]=-0.0;
+        z[0]=double_complex(1.e200,1.e200); z[1]=double_complex(1.e-200,0.0);
+
+        madness::vexp(n,x.data(),y.data());
+        madness::vsincos(n,x.data(),s.data(),c.data());
+        w=z;
+        madness::vexp(n,w.data(),w.data());
+        madness::vabs(n,z.data(),a.data());
+        for (long i=0; i<n; ++i) {
+            if (std::isfinite(y[i])) ASSERT_TRUE(check(y[i]/std::exp(x[i]),1.0,1e-15));
+            else ASSERT_EQ(y[i],std::exp(x[i]));
+            ASSERT_TRUE(check(s[i],std::sin(x[i]),1e-15));
+            ASSERT_TRUE(check(c[i],std::cos(x[i]),1e-15));
+            if (z[i]!=0.0) ASSERT_TRUE(check(a[i]/std::abs(z[i]),1.0,1e-15));
+            else ASSERT_EQ(a[i],0.0);
+            if (i>1) ASSERT_TRUE(check(w[i]/std::exp(z[i]),1.0,1e-15));
+        }
+    }
+
 //     TYPED_TEST(TensorTest, Container) {
 //         typedef madness::ConcurrentHashMap< int, Tensor<TypeParam> > containerT;
 //         static const int N = 100;
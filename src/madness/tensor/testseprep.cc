@@ -949,6 +949,54 @@ int test_TT_operator_application(const long k, const long dim, const TensorArgs
     return nerror;
 }
 
+int test_TT_transform(const long k, const long dim, const TensorArgs targs) {
+    print("entering test_TT_transform");
+    print("k, dim, thresh ",k,dim,targs.thresh);
+
+    int nerror=0;
+    double eps=targs.thresh;
+
+    {
+        std::vector<long> d(dim,k);
+        Tensor<double> t(d);
+        t.fillindex();
+        t.scale(1.0/t.normf());
+        TensorTrain<double> tt1(t,eps);
+
+        std::vector<Tensor<double> > c(dim);
+        for (int i=0; i<dim; ++i) {
+            c[i]=Tensor<double>(k,k);
+            c[i].fillrandom();
+        }
+
+        // all dimensions with distinct matrices
+        Tensor<double> ref=general_transform(t,&c[0]);
+        double error1=(ref-general_transform(tt1,&c[0]).reconstruct()).normf()/ref.normf();
+        print(ok(is_small(error1,eps)),"general_transform;  k=",k,"dim=",dim,"error=",error1);
+        if (!is_small(error1,eps)) nerror++;
+
+        // all dimensions with the same matrix
+        ref=transform(t,c[0]);
+        double error2=(ref-transform(tt1,c[0]).reconstruct()).normf()/ref.normf();
+        print(ok(is_small(error2,eps)),"transform;          k=",k,"dim=",dim,"error=",error2);
+        if (!is_small(error2,eps)) nerror++;
+
+        // a single dimension
+        for (int axis=0; axis<dim; ++axis) {
+            ref=transform_dir(t,c[axis],axis);
+            double error3=(ref-transform_dir(tt1,c[axis],axis).reconstruct()).normf()/ref.normf();
+            print(ok(is_small(error3,eps)),"transform_dir;      k=",k,"dim=",dim,"axis=",axis,"error=",error3);
+            if (!is_small(error3,eps)) nerror++;
+        }
+
+        // flat reconstruction
+        double error4=(t.flat()-tt1.reconstruct(true)).normf();
+        print(ok(is_small(error4,eps)),"flat reconstruct;   k=",k,"dim=",dim,"error=",error4);
+        if (!is_small(error4,eps)) nerror++;
+    }
+    return nerror;
+}
+
 int main(int argc, char**argv) {
 
 //    initialize(argc,argv);
@@ -974,6 +1022,7 @@ int main(int argc, char**argv) {
     	    error+=testTensorTrain(kk,d,TensorArgs(eps,TT_2D));
     	    error+=test_TT_truncate(kk,d,TensorArgs(eps,TT_2D));
             error+=test_TT_operator_application(kk,d,TensorArgs(eps,TT_2D));
+            error+=test_TT_transform(kk,d,TensorArgs(eps,TT_2D));
     	}
     }
 
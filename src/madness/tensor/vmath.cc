@@ -38,10 +38,14 @@
 
 #include <complex>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 
 typedef std::complex<double> double_complex;
 
 #include <madness/madness_config.h>
+#include <madness/tensor/vmath.h>
 #ifdef HAVE_INTEL_MKL
 #include <mkl.h>
 
@@ -71,7 +75,7 @@ void vzExp(int n, const double_complex* x, double_complex* y) {
     vdExp(n, a, expa);
     vdSinCos(n, b, sinb, cosb);
     for (int i=0; i<n; ++i) {
-        y[i] = double_complex(a[i]*cosb[i],a[i]*sinb[i]);
+        y[i] = double_complex(expa[i]*cosb[i],expa[i]*sinb[i]);
     }
     delete[] cosb;
     delete[] sinb;
@@ -83,7 +87,157 @@ void vzExp(int n, const double_complex* x, double_complex* y) {
 #else
 
 void vzExp(int n, const double_complex* x, double_complex* y) {
-    for (int i=0; i<n; ++i) y[i] = exp(x[i]);
+    madness::vexp(n, x, y);
 }
 
 #endif
+
+namespace madness {
+
+    namespace {
+
+        // length of the blocks held in local buffers, so that the input
+        // and output may be the same array
+        const long vblock = 256;
+
+        // adding and subtracting 1.5*2^52 rounds to the nearest integer,
+        // which is then found in the low bits of the sum
+        const double round_magic = 6755399441055744.0;
+
+        inline uint64_t to_bits(double x) {
+            uint64_t b;
+            std::memcpy(&b, &x, sizeof(b));
+            return b;
+        }
+
+        inline double from_bits(uint64_t b) {
+            double x;
+            std::memcpy(&x, &b, sizeof(x));
+            return x;
+        }
+
+        /// exp for |x|<=708: x = k ln2 + r with |r|<=ln2/2, exp(x) = 2^k exp(r)
+        void exp_block(long n, const double* MADNESS_RESTRICT x, double* MADNESS_RESTRICT y) {
+            const double log2e = 1.44269504088896338700e+00;
+            const double ln2_hi = 6.93147180369123816490e-01;   // 32 bits, k*ln2_hi is exact
+            const double ln2_lo = 1.90821492927058770002e-10;
+            for (long i=0; i<n; ++i) {
+                // arguments out of range give garbage here and are redone below
+                const double xi = x[i];
+                const double t = xi*log2e + round_magic;
+                const double k = t - round_magic;
+                const double r = (xi - k*ln2_hi) - k*ln2_lo;
+                // Taylor series to r^13, truncation error < 1e-17 for |r|<=ln2/2
+                double p = 1.0/6227020800.0;
+                p = p*r + 1.0/479001600.0;
+                p = p*r + 1.0/39916800.0;
+                p = p*r + 1.0/3628800.0;
+                p = p*r + 1.0/362880.0;
+                p = p*r + 1.0/40320.0;
+                p = p*r + 1.0/5040.0;
+                p = p*r + 1.0/720.0;
+                p = p*r + 1.0/120.0;
+                p = p*r + 1.0/24.0;
+                p = p*r + 1.0/6.0;
+                p = p*r + 0.5;
+                p = p*r*r + r;
+                // 2^k from the low bits of t, |k|<=1022
+                y[i] = (1.0 + p)*from_bits((to_bits(t) + 1023) << 52);
+            }
+            for (long i=0; i<n; ++i) {
+                if (!(std::abs(x[i]) <= 708.0)) y[i] = std::exp(x[i]);
+            }
+        }
+
+        /// sin and cos for |x|<=1e5: x = q pi/2 + r with |r|<=pi/4
+        void sincos_block(long n, const double* MADNESS_RESTRICT x,
+                          double* MADNESS_RESTRICT sinx, double* MADNESS_RESTRICT cosx) {
+            const double two_over_pi = 6.36619772367581382433e-01;
+            // pi/2 in three parts of 33 bits, q*pio2_1 and q*pio2_2 are exact for |q|<2^20
+            const double pio2_1 = 1.57079632673412561417e+00;
+            const double pio2_2 = 6.07710050630396597660e-11;
+            const double pio2_3 = 2.02226624871116645580e-21;
+            // minimax polynomials of fdlibm's __kernel_sin and __kernel_cos
+            const double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03,
+                S3 = -1.98412698298579493134e-04, S4 = 2.75573137070700676789e-06,
+                S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+            const double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+                C3 = 2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+                C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+            for (long i=0; i<n; ++i) {
+                // arguments out of range give garbage here and are redone below
+                const double xi = x[i];
+                const double t = xi*two_over_pi + round_magic;
+                const double q = t - round_magic;
+                const double r = ((xi - q*pio2_1) - q*pio2_2) - q*pio2_3;
+                const double z = r*r;
+                const double s = r + r*z*(S1 + z*(S2 + z*(S3 + z*(S4 + z*(S5 + z*S6)))));
+                const double hz = 0.5*z;
+                const double w = 1.0 - hz;
+                const double c = w + (((1.0 - w) - hz) + z*z*(C1 + z*(C2 + z*(C3 + z*(C4 + z*(C5 + z*C6))))));
+
+                // the quadrant q mod 4 swaps sin and cos and flips their signs
+                const uint64_t quadrant = to_bits(t);
+                const uint64_t swap = -(quadrant & 1);
+                const uint64_t sbits = to_bits(s), cbits = to_bits(c);
+                sinx[i] = from_bits(((cbits & swap) | (sbits & ~swap)) ^ ((quadrant & 2) << 62));
+                cosx[i] = from_bits(((sbits & swap) | (cbits & ~swap)) ^ (((quadrant + 1) & 2) << 62));
+            }
+            for (long i=0; i<n; ++i) {
+                if (!(std::abs(x[i]) <= 1.e5)) {
+                    sinx[i] = std::sin(x[i]);
+                    cosx[i] = std::cos(x[i]);
+                }
+            }
+        }
+    }
+
+    void vexp(long n, const double* x, double* y) {
+        double xb[vblock];
+        for (long i=0; i<n; i+=vblock) {
+            const long m = std::min(vblock, n-i);
+            std::copy(x+i, x+i+m, xb);
+            exp_block(m, xb, y+i);
+        }
+    }
+
+    void vsincos(long n, const double* x, double* sinx, double* cosx) {
+        double xb[vblock];
+        for (long i=0; i<n; i+=vblock) {
+            const long m = std::min(vblock, n-i);
+            std::copy(x+i, x+i+m, xb);
+            sincos_block(m, xb, sinx+i, cosx+i);
+        }
+    }
+
+    void vexp(long n, const double_complex* x, double_complex* y) {
+        double a[vblock], b[vblock], expa[vblock], sinb[vblock], cosb[vblock];
+        for (long i=0; i<n; i+=vblock) {
+            const long m = std::min(vblock, n-i);
+            const double* MADNESS_RESTRICT xi = reinterpret_cast<const double*>(x+i);
+            for (long j=0; j<m; ++j) {
+                a[j] = xi[2*j];
+                b[j] = xi[2*j+1];
+            }
+            exp_block(m, a, expa);
+            sincos_block(m, b, sinb, cosb);
+            double* MADNESS_RESTRICT yi = reinterpret_cast<double*>(y+i);
+            for (long j=0; j<m; ++j) {
+                yi[2*j] = expa[j]*cosb[j];
+                yi[2*j+1] = expa[j]*sinb[j];
+            }
+        }
+    }
+
+    void vabs(long n, const double_complex* x, double* y) {
+        const double* MADNESS_RESTRICT xr = reinterpret_cast<const double*>(x);
+        for (long i=0; i<n; ++i) {
+            y[i] = std::sqrt(xr[2*i]*xr[2*i] + xr[2*i+1]*xr[2*i+1]);
+        }
+        // the sum of squares over- or underflows, or is inf or nan
+        for (long i=0; i<n; ++i) {
+            if (!(y[i] <= 1.e150) || (y[i] < 1.e-150 && x[i] != 0.0)) y[i] = std::abs(x[i]);
+        }
+    }
+
+}
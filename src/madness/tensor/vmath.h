@@ -34,13 +34,39 @@
 #define MADNESS_TENSOR_VMATH_H__INCLUDED
 
 #include <madness/madness_config.h>
+#include <complex>
 
 #ifdef HAVE_INTEL_MKL
 #include <mkl.h>
 
-#elif defined(HAVE_ACML)
-void vzExp(int n, const double_complex* x, double_complex* y);
+#else
+void vzExp(int n, const std::complex<double>* x, std::complex<double>* y);
 #endif
 
+namespace madness {
+
+    /* Vector math kernels for contiguous arrays.  They do not depend on a
+     * vector math library: the arguments are reduced and the polynomials
+     * evaluated in simple loops over blocks of the arrays, which the compiler
+     * vectorizes.  The results agree with the C++ library to about one unit in
+     * the last place.  Arguments outside the reduced range (|x|>708 for exp,
+     * |x|>1e5 for sin and cos, over- or underflowing moduli, inf and nan) are
+     * passed to the C++ library.  The input and output arrays may be the
+     * same. */
+
+    /// y[i] = exp(x[i])
+    void vexp(long n, const double* x, double* y);
+
+    /// sinx[i] = sin(x[i]) and cosx[i] = cos(x[i])
+    void vsincos(long n, const double* x, double* sinx, double* cosx);
+
+    /// y[i] = exp(x[i]) for complex x
+    void vexp(long n, const std::complex<double>* x, std::complex<double>* y);
+
+    /// y[i] = abs(x[i]) for complex x
+    void vabs(long n, const std::complex<double>* x, double* y);
+
+}
+
 #endif // MADNESS_TENSOR_VMATH_H__INCLUDED
 
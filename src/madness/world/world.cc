@@ -43,6 +43,7 @@
 #include <madness/world/worldgop.h>
 #include <cstdlib>
 #include <sstream>
+#include <vector>
 
 #ifdef MADNESS_HAS_ELEMENTAL
 #if defined(HAVE_EL_H)
@@ -64,6 +65,7 @@ namespace madness {
         double start_wall_time; ///< \todo Documentation needed.
         bool madness_initialized_ = false;  ///< Tracks if MADNESS has been initialized.
         bool madness_quiet_ = false;  ///< Tracks if madness::initialize() requested quiet operation
+        std::vector<void (*)()> finalize_callbacks; ///< Registered with at_finalize()
     } // namespace
 
     // World static member variables
@@ -229,8 +231,17 @@ namespace madness {
         return * World::default_world;
     }
 
+    void at_finalize(void (*f)()) {
+        finalize_callbacks.push_back(f);
+    }
+
     void finalize() {
         World::default_world->gop.fence();
+        while (!finalize_callbacks.empty()) {
+            void (*f)() = finalize_callbacks.back();
+            finalize_callbacks.pop_back();
+            f();
+        }
         const auto rank = World::default_world->rank();
         const auto world_size = World::default_world->size();
 
@@ -104,6 +104,13 @@ namespace madness {
     /// Call this once at the very end of your main program instead of MPI_Finalize().
     void finalize();
 
+    /// Registers a function that finalize() calls while the runtime is still up.
+
+    /// The functions are called in the reverse order of registration, after
+    /// the default world has been fenced.
+    /// \param[in] f The function to call.
+    void at_finalize(void (*f)());
+
     /// Check if the MADNESS runtime has been initialized (and not subsequently finalized).
 
     /// @return true if \c madness::initialize had been called more recently than \c madness::finalize, false otherwise.